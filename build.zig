@@ -21,13 +21,20 @@ pub fn build(b: *std.Build) void {
 
     const exe = b.addExecutable(.{ .name = name.items, .target = target, .optimize = optimize });
 
-    const cFiles = [_][]const u8{ "src/main.c", "src/DEV.c", "src/renderer/renderer.c", "src/renderer/text_renderer.c", "src/components/components.c" };
+    const cFiles = [_][]const u8{ "src/main.c", "src/DEV.c", "src/renderer/renderer.c", "src/renderer/text_renderer.c", "src/renderer/gpu_ring_buffer.c", "src/renderer/atlas_packer.c", "src/renderer/glyph_rasterizer.c", "src/renderer/font_file.c", "src/renderer/font_coverage.c", "src/renderer/font_kerning.c", "src/renderer/glyph_table.c", "src/renderer/utf8_decoder.c", "src/components/components.c" };
+
+    // 基准测试复用渲染器与组件源码，以 bench.c 替代 main.c
+    const benchFiles = [_][]const u8{ "src/bench/bench.c", "src/DEV.c", "src/renderer/renderer.c", "src/renderer/text_renderer.c", "src/renderer/gpu_ring_buffer.c", "src/renderer/atlas_packer.c", "src/renderer/glyph_rasterizer.c", "src/renderer/font_file.c", "src/renderer/font_coverage.c", "src/renderer/font_kerning.c", "src/renderer/glyph_table.c", "src/renderer/utf8_decoder.c", "src/components/components.c" };
+
+    // 编译期日志级别：Debug 保留全部日志，Release 只保留警告和错误（见 DEV.h）
+    const logLevelFlag = if (optimize == .Debug) "-DLOG_COMPILE_LEVEL=0" else "-DLOG_COMPILE_LEVEL=3";
 
     const cFlags = [_][]const u8{
         "-std=c99",
         // UTF-8 编码
         "-D_UNICODE",
         "-DUNICODE",
+        logLevelFlag,
     };
 
     exe.addCSourceFiles(.{
@@ -36,9 +43,35 @@ pub fn build(b: *std.Build) void {
     });
 
     exe.addIncludePath(b.path("include"));
+    linkPlatformLibraries(b, exe);
 
+    exe.linkLibC();
+    b.installArtifact(exe);
+
+    // 基准测试: zig build bench -- --cards 256 --sweep 4 --out bench.json
+    const bench = b.addExecutable(.{ .name = "clay-bench", .target = target, .optimize = optimize });
+    bench.addCSourceFiles(.{
+        .files = &benchFiles,
+        .flags = &cFlags,
+    });
+    bench.addIncludePath(b.path("include"));
+    linkPlatformLibraries(b, bench);
+    bench.linkLibC();
+
+    const bench_install = b.addInstallArtifact(bench, .{});
+    const bench_run = b.addRunArtifact(bench);
+    bench_run.step.dependOn(&bench_install.step);
+    if (b.args) |args| {
+        bench_run.addArgs(args);
+    }
+    const bench_step = b.step("bench", "Run the frame-time benchmark (JSON output)");
+    bench_step.dependOn(&bench_run.step);
+}
+
+// 平台库配置（主程序与基准测试共用）
+fn linkPlatformLibraries(b: *std.Build, exe: *std.Build.Step.Compile) void {
     // 根据目标操作系统调整编译配置
-    const os_tag = target.result.os.tag;
+    const os_tag = exe.rootModuleTarget().os.tag;
 
     // 设置平台特定的库路径和链接库
     switch (os_tag) {
@@ -111,7 +144,4 @@ pub fn build(b: *std.Build) void {
             exe.linkSystemLibrary("wgpu_native");
         },
     }
-
-    exe.linkLibC();
-    b.installArtifact(exe);
 }
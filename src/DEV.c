@@ -1,13 +1,220 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
 #include "DEV.h"
 #include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
 
 const bool DEV_MODE = false;
 
-void Log(const char *format, ...) {
-  if (DEV_MODE) {
-    va_list args;
-    va_start(args, format);
-    vprintf_s(format, args);
-    va_end(args);
+#ifdef _WIN32
+typedef CRITICAL_SECTION LogMutex;
+typedef CONDITION_VARIABLE LogCondition;
+typedef HANDLE LogThread;
+#else
+typedef pthread_mutex_t LogMutex;
+typedef pthread_cond_t LogCondition;
+typedef pthread_t LogThread;
+#endif
+
+// 日志在生产者线程中格式化完成，后台线程只负责写出
+static struct {
+  char entries[LOG_RING_CAPACITY][LOG_MESSAGE_SIZE];
+  unsigned long head; // 下一个写入位置（单调递增）
+  unsigned long tail; // 下一个待写出位置
+  unsigned long dropped;
+
+  LogMutex mutex;
+  LogCondition condition;
+  LogThread thread;
+  FILE *output;
+  bool running;
+} logSink;
+
+static volatile LogLevel logRuntimeLevel = LOG_LEVEL_WARN;
+
+static void log_lock(void) {
+#ifdef _WIN32
+  EnterCriticalSection(&logSink.mutex);
+#else
+  pthread_mutex_lock(&logSink.mutex);
+#endif
+}
+
+static void log_unlock(void) {
+#ifdef _WIN32
+  LeaveCriticalSection(&logSink.mutex);
+#else
+  pthread_mutex_unlock(&logSink.mutex);
+#endif
+}
+
+static void log_signal(void) {
+#ifdef _WIN32
+  WakeConditionVariable(&logSink.condition);
+#else
+  pthread_cond_signal(&logSink.condition);
+#endif
+}
+
+static void log_wait(void) {
+#ifdef _WIN32
+  SleepConditionVariableCS(&logSink.condition, &logSink.mutex, INFINITE);
+#else
+  pthread_cond_wait(&logSink.condition, &logSink.mutex);
+#endif
+}
+
+// 后台线程：批量写出 [tail, head) 区间，每批只刷新一次
+// 生产者只在 tail 前进后才会复用槽位，因此写出时无需持锁
+static void log_drain_loop(void) {
+  log_lock();
+  for (;;) {
+    while (logSink.running && logSink.head == logSink.tail) {
+      log_wait();
+    }
+    if (logSink.head == logSink.tail)
+      break;
+
+    unsigned long head = logSink.head;
+    unsigned long tail = logSink.tail;
+    log_unlock();
+
+    for (; tail != head; tail++) {
+      fputs(logSink.entries[tail % LOG_RING_CAPACITY], logSink.output);
+    }
+    fflush(logSink.output);
+
+    log_lock();
+    logSink.tail = tail;
+  }
+  log_unlock();
+}
+
+#ifdef _WIN32
+static DWORD WINAPI log_thread_main(LPVOID param) {
+  (void)param;
+  log_drain_loop();
+  return 0;
+}
+#else
+static void *log_thread_main(void *param) {
+  (void)param;
+  log_drain_loop();
+  return NULL;
+}
+#endif
+
+bool log_init(FILE *output, LogLevel runtime_level) {
+  if (logSink.running)
+    return true;
+
+  logSink.output = output ? output : stderr;
+  logSink.head = 0;
+  logSink.tail = 0;
+  logSink.dropped = 0;
+  logRuntimeLevel = runtime_level;
+
+#ifdef _WIN32
+  InitializeCriticalSection(&logSink.mutex);
+  InitializeConditionVariable(&logSink.condition);
+  logSink.running = true;
+  logSink.thread = CreateThread(NULL, 0, log_thread_main, NULL, 0, NULL);
+  if (!logSink.thread) {
+    logSink.running = false;
+    DeleteCriticalSection(&logSink.mutex);
+    return false;
+  }
+#else
+  pthread_mutex_init(&logSink.mutex, NULL);
+  pthread_cond_init(&logSink.condition, NULL);
+  logSink.running = true;
+  if (pthread_create(&logSink.thread, NULL, log_thread_main, NULL) != 0) {
+    logSink.running = false;
+    pthread_cond_destroy(&logSink.condition);
+    pthread_mutex_destroy(&logSink.mutex);
+    return false;
+  }
+#endif
+  return true;
+}
+
+void log_shutdown(void) {
+  if (!logSink.running)
+    return;
+
+  log_lock();
+  logSink.running = false;
+  log_signal();
+  log_unlock();
+
+#ifdef _WIN32
+  WaitForSingleObject(logSink.thread, INFINITE);
+  CloseHandle(logSink.thread);
+  DeleteCriticalSection(&logSink.mutex);
+#else
+  pthread_join(logSink.thread, NULL);
+  pthread_cond_destroy(&logSink.condition);
+  pthread_mutex_destroy(&logSink.mutex);
+#endif
+
+  if (logSink.dropped > 0) {
+    fprintf(logSink.output, "日志缓冲区已满，丢弃 %lu 条日志\n",
+            logSink.dropped);
+  }
+  fflush(logSink.output);
+}
+
+void log_set_level(LogLevel runtime_level) { logRuntimeLevel = runtime_level; }
+
+unsigned long log_dropped_count(void) { return logSink.dropped; }
+
+bool log_enabled(LogLevel level) { return level >= logRuntimeLevel; }
+
+void log_write(const char *format, ...) {
+  char message[LOG_MESSAGE_SIZE];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+
+  // 未启动后台线程时同步写出
+  if (!logSink.running) {
+    fputs(message, stderr);
+    return;
+  }
+
+  log_lock();
+  if (logSink.head - logSink.tail >= LOG_RING_CAPACITY) {
+    // 缓冲区满时丢弃而不是阻塞渲染线程
+    logSink.dropped++;
+  } else {
+    memcpy(logSink.entries[logSink.head % LOG_RING_CAPACITY], message,
+           sizeof(message));
+    logSink.head++;
+    log_signal();
   }
-}
\ No newline at end of file
+  log_unlock();
+}
+
+double GetTimeMs(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency = {0};
+  LARGE_INTEGER counter;
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
@@ -3,8 +3,60 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdio.h>
 
 extern const bool DEV_MODE;
-void Log(const char *format, ...);
+
+// 日志级别
+typedef enum {
+  LOG_LEVEL_TRACE = 0, // 每字形/每命令的热路径日志
+  LOG_LEVEL_DEBUG = 1, // 每帧/每批次日志
+  LOG_LEVEL_INFO = 2,  // 初始化、资源加载等一次性事件
+  LOG_LEVEL_WARN = 3,
+  LOG_LEVEL_ERROR = 4,
+  LOG_LEVEL_NONE = 5,
+} LogLevel;
+
+// 编译期日志级别：低于该级别的 LOG_* 宏在编译期被消除
+// 由 build.zig 按优化模式传入（Debug 为 TRACE，Release 为 WARN）
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+
+// 异步日志环形缓冲区
+#define LOG_RING_CAPACITY 1024 // 缓冲的日志条数（2的幂）
+#define LOG_MESSAGE_SIZE 256   // 单条日志的最大长度（超出部分截断）
+
+// 运行时级别判断与写入，不要直接调用，使用下方的 LOG_* 宏
+bool log_enabled(LogLevel level);
+void log_write(const char *format, ...);
+
+// 被编译期消除的级别保留 if (0) 形式：参数仍做类型检查，但不产生任何代码
+#define LOG_AT(level, ...)                                                     \
+  do {                                                                         \
+    if ((level) >= LOG_COMPILE_LEVEL && log_enabled(level))                    \
+      log_write(__VA_ARGS__);                                                  \
+  } while (0)
+
+#define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+// 启动后台写入线程，output 为日志目标（NULL 时为 stderr）
+// 未启动时日志同步写入 stderr
+bool log_init(FILE *output, LogLevel runtime_level);
+// 写出缓冲区中剩余日志并停止后台线程
+void log_shutdown(void);
+void log_set_level(LogLevel runtime_level);
+// 环形缓冲区满时被丢弃的日志条数
+unsigned long log_dropped_count(void);
+
+// 兼容旧接口，等同于 LOG_INFO
+#define Log(...) LOG_INFO(__VA_ARGS__)
+
+// 单调时钟（毫秒），用于分阶段计时
+double GetTimeMs(void);
 
 #endif
@@ -0,0 +1,498 @@
+// bench.c - 帧时间基准测试
+// 用可配置规模的合成 Clay 布局驱动无窗口渲染器，分阶段计时并输出 JSON
+//
+// 参数: [--cards N] [--texts N] [--depth N] [--cjk 0..100] [--no-scroll]
+//       [--frames N] [--warmup N] [--sweep N] [--size WIDTHxHEIGHT]
+//       [--font path] [--software] [--sdf] [--sync-glyphs] [--out result.json]
+#include "../DEV.h"
+#include "../components/components.h"
+#include "../renderer/renderer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 合成布局的规模参数
+typedef struct {
+  int cards;      // 卡片数量（每行4张）
+  int texts;      // 独立文本段数量
+  int depth;      // 嵌套深度
+  int cjkPercent; // 文本段中CJK文本的比例
+  bool scroll;    // 是否把内容放入滚动容器
+  bool sdf;       // 使用SDF文本渲染
+  bool syncGlyphs; // 在渲染线程上同步光栅化字形（对比后台光栅化）
+} BenchLayoutConfig;
+
+// 单阶段统计（毫秒）
+typedef struct {
+  double sum;
+  double min;
+  double max;
+} BenchStat;
+
+typedef struct {
+  BenchStat layout;    // Clay_BeginLayout 到 Clay_EndLayout（含文本测量）
+  BenchStat measure;   // 文本测量（layout 的子集）
+  BenchStat translate; // 渲染命令转换（含字形生成）
+  BenchStat glyph;     // 字形生成（translate 的子集）
+  BenchStat upload;    // 缓冲区与图集上传
+  BenchStat submit;    // 编码与提交
+  BenchStat gpuWait;   // 等待GPU完成
+  BenchStat frame;     // 整帧
+  int samples;
+} BenchStats;
+
+typedef struct {
+  WGPUInstance instance;
+  WGPUDevice device;
+  WGPUQueue queue;
+  Clay_WebGPU_Context *renderer;
+  bool softwareAdapter;
+  uint32_t width;
+  uint32_t height;
+  double measureMs; // 当前帧文本测量累计耗时
+} BenchContext;
+
+static const char *LATIN_TEXTS[] = {
+    "The quick brown fox jumps over the lazy dog",
+    "Layout engines spend most of their time in text measurement",
+    "Frame time budget at 60 Hz is roughly sixteen milliseconds",
+    "Glyph atlas uploads should be incremental, not whole-texture",
+};
+
+static const char *CJK_TEXTS[] = {
+    "你好世界！这是中文文本渲染测试。",
+    "基于窗口大小的自适应布局与动态组件重排",
+    "字形缓存命中率决定了文本渲染的整体性能",
+    "滚动容器中的大量文本需要裁剪与批处理",
+};
+
+#define BENCH_TEXT_VARIANTS 4
+
+static Clay_String MakeString(const char *text) {
+  return (Clay_String){.length = (int32_t)strlen(text), .chars = text};
+}
+
+static void HandleClayErrors(Clay_ErrorData errorData) {
+  Log("Clay Error: %s\n", errorData.errorText.chars);
+}
+
+// 与 main.c 相同的测量方式，额外累计测量耗时
+static Clay_Dimensions MeasureText(Clay_StringSlice text,
+                                   Clay_TextElementConfig *config,
+                                   void *userData) {
+  BenchContext *bench = (BenchContext *)userData;
+  if (!bench->renderer || !bench->renderer->textRenderer) {
+    return (Clay_Dimensions){.width = text.length * config->fontSize * 0.6f,
+                             .height = config->fontSize};
+  }
+
+  double start = GetTimeMs();
+  float width = text_renderer_measure_string_width(
+      bench->renderer->textRenderer, text.chars, config->fontId, config->fontSize,
+      text.length);
+  float height = text_renderer_get_line_height(bench->renderer->textRenderer,
+                                               config->fontId, config->fontSize);
+  bench->measureMs += GetTimeMs() - start;
+
+  return (Clay_Dimensions){.width = width, .height = height};
+}
+
+static void OnAdapterRequestEnded(WGPURequestAdapterStatus status,
+                                  WGPUAdapter adapter, WGPUStringView message,
+                                  void *userdata1, void *userdata2) {
+  if (status == WGPURequestAdapterStatus_Success) {
+    *(WGPUAdapter *)userdata1 = adapter;
+  } else {
+    fprintf(stderr, "Failed to request adapter: %.*s\n", (int)message.length,
+            message.data);
+  }
+  *(bool *)userdata2 = true;
+}
+
+static void OnDeviceRequestEnded(WGPURequestDeviceStatus status,
+                                 WGPUDevice device, WGPUStringView message,
+                                 void *userdata1, void *userdata2) {
+  if (status == WGPURequestDeviceStatus_Success) {
+    *(WGPUDevice *)userdata1 = device;
+  } else {
+    fprintf(stderr, "Failed to request device: %.*s\n", (int)message.length,
+            message.data);
+  }
+  *(bool *)userdata2 = true;
+}
+
+// 无表面的设备初始化
+static bool InitializeDevice(BenchContext *bench) {
+  bench->instance = wgpuCreateInstance(&(WGPUInstanceDescriptor){0});
+  if (!bench->instance)
+    return false;
+
+  WGPUAdapter adapter = NULL;
+  bool adapterRequestDone = false;
+  wgpuInstanceRequestAdapter(
+      bench->instance,
+      &(WGPURequestAdapterOptions){
+          .powerPreference = WGPUPowerPreference_HighPerformance,
+          .forceFallbackAdapter = bench->softwareAdapter},
+      (WGPURequestAdapterCallbackInfo){
+          .mode = WGPUCallbackMode_AllowProcessEvents,
+          .callback = OnAdapterRequestEnded,
+          .userdata1 = &adapter,
+          .userdata2 = &adapterRequestDone});
+  while (!adapterRequestDone) {
+    wgpuInstanceProcessEvents(bench->instance);
+  }
+  if (!adapter)
+    return false;
+
+  bool deviceRequestDone = false;
+  wgpuAdapterRequestDevice(adapter, &(WGPUDeviceDescriptor){0},
+                           (WGPURequestDeviceCallbackInfo){
+                               .mode = WGPUCallbackMode_AllowProcessEvents,
+                               .callback = OnDeviceRequestEnded,
+                               .userdata1 = &bench->device,
+                               .userdata2 = &deviceRequestDone});
+  while (!deviceRequestDone) {
+    wgpuInstanceProcessEvents(bench->instance);
+  }
+  wgpuAdapterRelease(adapter);
+  if (!bench->device)
+    return false;
+
+  bench->queue = wgpuDeviceGetQueue(bench->device);
+  return true;
+}
+
+static bool LoadBenchFont(BenchContext *bench, const char *fontPath) {
+  if (fontPath)
+    return Clay_WebGPU_LoadFont(bench->renderer, fontPath, 16);
+
+  const char *fontPaths[] = {
+#ifdef _WIN32
+      "./fonts/msyh.ttc",
+      "C:/Windows/Fonts/msyh.ttc",
+      "C:/Windows/Fonts/simhei.ttf",
+      "C:/Windows/Fonts/arial.ttf",
+#elif defined(__APPLE__)
+      "./fonts/PingFang.ttc",
+      "/System/Library/Fonts/PingFang.ttc",
+      "/System/Library/Fonts/STHeiti Medium.ttc",
+      "/System/Library/Fonts/Helvetica.ttc",
+#else
+      "./fonts/NotoSansCJK-Regular.ttc",
+      "/usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc",
+      "/usr/share/fonts/truetype/noto/NotoSansCJK-Regular.ttc",
+      "/usr/share/fonts/truetype/droid/DroidSansFallbackFull.ttf",
+      "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+#endif
+      NULL};
+
+  for (int i = 0; fontPaths[i] != NULL; i++) {
+    if (Clay_WebGPU_LoadFont(bench->renderer, fontPaths[i], 16))
+      return true;
+  }
+  return false;
+}
+
+// 递归嵌套：每层一个带内边距的容器，最内层放一段文本
+static void NestedLayout(int depth, int cjkPercent) {
+  if (depth <= 0) {
+    const char *text = cjkPercent >= 50 ? CJK_TEXTS[0] : LATIN_TEXTS[0];
+    CLAY_TEXT(MakeString(text),
+              CLAY_TEXT_CONFIG(
+                  {.fontId = 0, .fontSize = 14, .textColor = TEXT_COLOR}));
+    return;
+  }
+
+  CLAY({.layout = {.sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_FIT(0)},
+                   .padding = CLAY_PADDING_ALL(2)},
+        .backgroundColor = (depth & 1) ? CARD_COLOR : BACKGROUND_COLOR,
+        .cornerRadius = CLAY_CORNER_RADIUS(4)}) {
+    NestedLayout(depth - 1, cjkPercent);
+  }
+}
+
+static void BenchContent(const BenchLayoutConfig *config) {
+  // 卡片网格，每行4张
+  for (int row = 0; row * 4 < config->cards; row++) {
+    CLAY({.layout = {.sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_FIT(0)},
+                     .layoutDirection = CLAY_LEFT_TO_RIGHT,
+                     .childGap = 20}}) {
+      for (int col = 0; col < 4 && row * 4 + col < config->cards; col++) {
+        int index = row * 4 + col;
+        bool cjk = (index % BENCH_TEXT_VARIANTS) * 100 / BENCH_TEXT_VARIANTS <
+                   config->cjkPercent;
+        const char **table = cjk ? CJK_TEXTS : LATIN_TEXTS;
+        CardComponent(MakeString(table[index % BENCH_TEXT_VARIANTS]),
+                      MakeString(table[(index + 1) % BENCH_TEXT_VARIANTS]));
+      }
+    }
+  }
+
+  // 独立文本段，按比例混合拉丁与CJK文本
+  for (int i = 0; i < config->texts; i++) {
+    bool cjk = (i % 100) < config->cjkPercent;
+    const char **table = cjk ? CJK_TEXTS : LATIN_TEXTS;
+    CLAY_TEXT(MakeString(table[i % BENCH_TEXT_VARIANTS]),
+              CLAY_TEXT_CONFIG({.fontId = 0,
+                                .fontSize = 14 + (i % 3) * 2,
+                                .textColor = TEXT_COLOR}));
+  }
+
+  if (config->depth > 0)
+    NestedLayout(config->depth, config->cjkPercent);
+}
+
+static void CreateBenchLayout(const BenchLayoutConfig *config) {
+  Clay_BeginLayout();
+  CLAY({.id = CLAY_ID("BenchRoot"),
+        .layout = {.sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)},
+                   .layoutDirection = CLAY_TOP_TO_BOTTOM},
+        .backgroundColor = BACKGROUND_COLOR}) {
+    HeaderComponent(CLAY_STRING("Clay 基准测试"));
+
+    if (config->scroll) {
+      CLAY({.id = CLAY_ID("BenchScroll"),
+            .layout = {.sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)},
+                       .padding = {20, 20, 20, 20},
+                       .childGap = 20,
+                       .layoutDirection = CLAY_TOP_TO_BOTTOM},
+            .clip = {.vertical = true, .childOffset = Clay_GetScrollOffset()}}) {
+        BenchContent(config);
+      }
+    } else {
+      CLAY({.layout = {.sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)},
+                       .padding = {20, 20, 20, 20},
+                       .childGap = 20,
+                       .layoutDirection = CLAY_TOP_TO_BOTTOM}}) {
+        BenchContent(config);
+      }
+    }
+  }
+}
+
+static void StatReset(BenchStat *stat) {
+  stat->sum = 0.0;
+  stat->min = 1e30;
+  stat->max = 0.0;
+}
+
+static void StatAdd(BenchStat *stat, double value) {
+  stat->sum += value;
+  if (value < stat->min)
+    stat->min = value;
+  if (value > stat->max)
+    stat->max = value;
+}
+
+static void WriteStat(FILE *out, const char *name, const BenchStat *stat,
+                      int samples, bool last) {
+  fprintf(out, "        \"%s\": {\"mean\": %.4f, \"min\": %.4f, \"max\": %.4f}%s\n",
+          name, samples > 0 ? stat->sum / samples : 0.0,
+          samples > 0 ? stat->min : 0.0, stat->max, last ? "" : ",");
+}
+
+// 运行一组配置：先预热，再采样；首帧单独记录（冷缓存）
+static void RunBench(BenchContext *bench, const BenchLayoutConfig *config,
+                     int warmup, int frames, FILE *out, bool last) {
+  BenchStats stats = {0};
+  StatReset(&stats.layout);
+  StatReset(&stats.measure);
+  StatReset(&stats.translate);
+  StatReset(&stats.glyph);
+  StatReset(&stats.upload);
+  StatReset(&stats.submit);
+  StatReset(&stats.gpuWait);
+  StatReset(&stats.frame);
+
+  double coldFrameMs = 0.0;
+  uint64_t atlasUploadBytes = 0; // 含预热帧，反映首次出现的字形的上传量
+  uint32_t commandCount = 0;
+  Clay_WebGPU_FrameTimings timings = {0};
+
+  for (int frame = 0; frame < warmup + frames; frame++) {
+    TextRenderer *textRenderer = bench->renderer->textRenderer;
+    if (textRenderer)
+      text_renderer_reset_stats(textRenderer);
+    bench->measureMs = 0.0;
+
+    double frameStart = GetTimeMs();
+
+    Clay_SetLayoutDimensions((Clay_Dimensions){bench->width, bench->height});
+    Clay_SetPointerState((Clay_Vector2){0, 0}, false);
+    Clay_UpdateScrollContainers(true, (Clay_Vector2){0, 0}, 0.016f);
+    CreateBenchLayout(config);
+    Clay_RenderCommandArray renderCommands = Clay_EndLayout();
+    double layoutEnd = GetTimeMs();
+
+    Clay_WebGPU_Render(bench->renderer, renderCommands);
+    double renderEnd = GetTimeMs();
+
+    wgpuDevicePoll(bench->device, true, NULL);
+    double frameEnd = GetTimeMs();
+
+    if (textRenderer)
+      atlasUploadBytes += textRenderer->atlas_upload_bytes;
+    if (frame == 0)
+      coldFrameMs = frameEnd - frameStart;
+    if (frame < warmup)
+      continue;
+
+    timings = bench->renderer->lastFrameTimings;
+    commandCount = (uint32_t)renderCommands.length;
+    StatAdd(&stats.layout, layoutEnd - frameStart);
+    StatAdd(&stats.measure, bench->measureMs);
+    StatAdd(&stats.translate, timings.translateMs);
+    StatAdd(&stats.glyph,
+            textRenderer ? textRenderer->glyph_generation_ms : 0.0);
+    StatAdd(&stats.upload, timings.uploadMs);
+    StatAdd(&stats.submit, timings.submitMs);
+    StatAdd(&stats.gpuWait, frameEnd - renderEnd);
+    StatAdd(&stats.frame, frameEnd - frameStart);
+    stats.samples++;
+  }
+
+  fprintf(out, "    {\n");
+  fprintf(out,
+          "      \"config\": {\"cards\": %d, \"texts\": %d, \"depth\": %d, "
+          "\"cjkPercent\": %d, \"scroll\": %s, \"sdf\": %s, "
+          "\"asyncGlyphs\": %s, \"width\": %u, \"height\": %u},\n",
+          config->cards, config->texts, config->depth, config->cjkPercent,
+          config->scroll ? "true" : "false", config->sdf ? "true" : "false",
+          config->syncGlyphs ? "false" : "true", bench->width, bench->height);
+  fprintf(out,
+          "      \"counts\": {\"renderCommands\": %u, \"drawRanges\": %u, "
+          "\"rectInstances\": %u, \"textChars\": %u, "
+          "\"atlasUploadBytes\": %llu},\n",
+          commandCount, timings.drawCount, timings.rectInstanceCount,
+          timings.textCharCount, (unsigned long long)atlasUploadBytes);
+  fprintf(out, "      \"coldFrameMs\": %.4f,\n", coldFrameMs);
+  fprintf(out, "      \"samples\": %d,\n", stats.samples);
+  fprintf(out, "      \"stagesMs\": {\n");
+  WriteStat(out, "layout", &stats.layout, stats.samples, false);
+  WriteStat(out, "measure", &stats.measure, stats.samples, false);
+  WriteStat(out, "translate", &stats.translate, stats.samples, false);
+  WriteStat(out, "glyphGeneration", &stats.glyph, stats.samples, false);
+  WriteStat(out, "upload", &stats.upload, stats.samples, false);
+  WriteStat(out, "submit", &stats.submit, stats.samples, false);
+  WriteStat(out, "gpuWait", &stats.gpuWait, stats.samples, false);
+  WriteStat(out, "frame", &stats.frame, stats.samples, true);
+  fprintf(out, "      }\n");
+  fprintf(out, "    }%s\n", last ? "" : ",");
+}
+
+int main(int argc, char **argv) {
+  BenchLayoutConfig config = {
+      .cards = 64, .texts = 256, .depth = 16, .cjkPercent = 50, .scroll = true};
+  BenchContext bench = {.width = 1200, .height = 800};
+  int frames = 100;
+  int warmup = 5;
+  int sweep = 1; // 规模扩展步数，每步元素数量翻倍
+  const char *fontPath = NULL;
+  const char *outPath = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--cards") == 0 && i + 1 < argc) {
+      config.cards = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--texts") == 0 && i + 1 < argc) {
+      config.texts = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+      config.depth = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--cjk") == 0 && i + 1 < argc) {
+      config.cjkPercent = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--no-scroll") == 0) {
+      config.scroll = false;
+    } else if (strcmp(argv[i], "--sdf") == 0) {
+      config.sdf = true;
+    } else if (strcmp(argv[i], "--sync-glyphs") == 0) {
+      config.syncGlyphs = true;
+    } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+      warmup = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+      sweep = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) {
+      fontPath = argv[++i];
+    } else if (strcmp(argv[i], "--software") == 0) {
+      bench.softwareAdapter = true;
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      outPath = argv[++i];
+    } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      unsigned int width, height;
+      if (sscanf(argv[++i], "%ux%u", &width, &height) == 2 && width > 0 &&
+          height > 0) {
+        bench.width = width;
+        bench.height = height;
+      }
+    }
+  }
+  if (sweep < 1)
+    sweep = 1;
+  if (frames < 1)
+    frames = 1;
+  if (config.cjkPercent < 0)
+    config.cjkPercent = 0;
+  if (config.cjkPercent > 100)
+    config.cjkPercent = 100;
+
+  if (!InitializeDevice(&bench)) {
+    fprintf(stderr, "Failed to initialize WebGPU device\n");
+    return 1;
+  }
+
+  // 按最大一步的规模预留 Clay 元素容量
+  int scale = 1 << (sweep - 1);
+  int32_t maxElements = (config.cards * 8 + config.texts * 2) * scale +
+                        config.depth * 2 + 1024;
+  if (maxElements > Clay_GetMaxElementCount())
+    Clay_SetMaxElementCount(maxElements);
+  if (maxElements * 4 > Clay_GetMaxMeasureTextCacheWordCount())
+    Clay_SetMaxMeasureTextCacheWordCount(maxElements * 4);
+
+  uint64_t totalMemorySize = Clay_MinMemorySize();
+  Clay_Arena arena = Clay_CreateArenaWithCapacityAndMemory(
+      totalMemorySize, malloc(totalMemorySize));
+  Clay_Initialize(arena, (Clay_Dimensions){bench.width, bench.height},
+                  (Clay_ErrorHandler){HandleClayErrors});
+  Clay_SetMeasureTextFunction(MeasureText, &bench);
+
+  bench.renderer = Clay_WebGPU_Initialize(bench.device, bench.queue, NULL,
+                                          bench.width, bench.height);
+  if (!bench.renderer || !Clay_WebGPU_CreateOffscreenTarget(
+                             bench.renderer, bench.width, bench.height)) {
+    fprintf(stderr, "Failed to initialize Clay WebGPU renderer\n");
+    return 1;
+  }
+  Clay_WebGPU_SetTextSdfMode(bench.renderer, config.sdf);
+  Clay_WebGPU_SetTextAsyncRaster(bench.renderer, !config.syncGlyphs);
+  if (!LoadBenchFont(&bench, fontPath)) {
+    fprintf(stderr, "Warning: no font loaded, text stages will be empty\n");
+  }
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "Failed to open %s\n", outPath);
+    return 1;
+  }
+
+  fprintf(out, "{\n  \"frames\": %d,\n  \"warmup\": %d,\n  \"runs\": [\n",
+          frames, warmup);
+  for (int step = 0; step < sweep; step++) {
+    BenchLayoutConfig stepConfig = config;
+    stepConfig.cards = config.cards << step;
+    stepConfig.texts = config.texts << step;
+    RunBench(&bench, &stepConfig, warmup, frames, out, step == sweep - 1);
+  }
+  fprintf(out, "  ]\n}\n");
+
+  if (out != stdout)
+    fclose(out);
+
+  wgpuDevicePoll(bench.device, true, NULL);
+  Clay_WebGPU_Cleanup(bench.renderer);
+  wgpuDeviceRelease(bench.device);
+  wgpuInstanceRelease(bench.instance);
+  free(arena.memory);
+  return 0;
+}
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef _WIN32
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -18,6 +19,11 @@
 #include <GLFW/glfw3native.h>
 #endif
 
+// 持久化字形缓存文件，与日志同在工作目录下
+#define GLYPH_CACHE_PATH "glyph_cache.bin"
+// 默认字体之外最多加入回退链的字体数
+#define MAX_FALLBACK_FONTS 3
+
 // 添加文件指针用于日志记录
 static FILE *logFile = NULL;
 
@@ -28,13 +34,15 @@ void SetupLogging() {
     // 重定向 stdout 和 stderr 到文件
     freopen("log.txt", "w", stdout);
     freopen("log.txt", "w", stderr);
-    setvbuf(stdout, NULL, _IONBF, 0); // 禁用缓冲，确保立即写入
-    setvbuf(stderr, NULL, _IONBF, 0);
   }
+
+  // 日志先写入环形缓冲区，由后台线程批量写出，不再逐条无缓冲写入
+  log_init(stdout, DEV_MODE ? LOG_LEVEL_TRACE : LOG_LEVEL_INFO);
 }
 
 // 恢复控制台输出的函数
 void RestoreConsole() {
+  log_shutdown();
   if (logFile) {
     fclose(logFile);
     logFile = NULL;
@@ -54,6 +62,13 @@ typedef struct {
   Clay_WebGPU_Context *clayRenderer;
   uint32_t windowWidth;
   uint32_t windowHeight;
+
+  // 无窗口模式：渲染到离屏纹理，不创建GLFW窗口和表面
+  bool headless;
+  bool softwareAdapter; // 请求软件/回退适配器（无GPU的构建机）
+  int headlessFrames;
+  const char *dumpPath; // 最后一帧保存为PPM（金图回归测试）
+  bool sdfText;         // 使用SDF文本渲染
 } AppContext;
 
 // Clay错误处理函数
@@ -74,10 +89,11 @@ Clay_Dimensions MeasureText(Clay_StringSlice text,
 
   // 使用文本渲染器测量文本
   float width = text_renderer_measure_string_width(
-      app->clayRenderer->textRenderer, text.chars, config->fontId, text.length);
+      app->clayRenderer->textRenderer, text.chars, config->fontId, config->fontSize,
+      text.length);
 
   float height = text_renderer_get_line_height(app->clayRenderer->textRenderer,
-                                               config->fontId);
+                                               config->fontId, config->fontSize);
 
   return (Clay_Dimensions){.width = width, .height = height};
 }
@@ -126,6 +142,7 @@ void OnAdapterRequestEnded(WGPURequestAdapterStatus status, WGPUAdapter adapter,
   } else {
     Log("Failed to request adapter: %.*s\n", (int)message.length, message.data);
   }
+  *(bool *)userdata2 = true;
 }
 
 // WebGPU设备请求回调函数
@@ -137,6 +154,7 @@ void OnDeviceRequestEnded(WGPURequestDeviceStatus status, WGPUDevice device,
   } else {
     Log("Failed to request device: %.*s\n", (int)message.length, message.data);
   }
+  *(bool *)userdata2 = true;
 }
 
 // WebGPU初始化 - 使用现代API
@@ -150,29 +168,34 @@ bool InitializeWebGPU(AppContext *app) {
   }
   Log("WebGPU instance created successfully\n");
 
-  // 创建表面
-  app->surface = CreateSurface(app->instance, app->window);
-  if (!app->surface) {
-    Log("Failed to create WebGPU surface\n");
-    return false;
+  // 创建表面（无窗口模式不需要）
+  if (!app->headless) {
+    app->surface = CreateSurface(app->instance, app->window);
+    if (!app->surface) {
+      Log("Failed to create WebGPU surface\n");
+      return false;
+    }
+    Log("WebGPU surface created successfully\n");
   }
-  Log("WebGPU surface created successfully\n");
 
   // 请求适配器 - 添加更详细的错误处理
   WGPURequestAdapterOptions adapterOptions = {
       .compatibleSurface = app->surface,
-      .powerPreference = WGPUPowerPreference_HighPerformance};
+      .powerPreference = WGPUPowerPreference_HighPerformance,
+      .forceFallbackAdapter = app->softwareAdapter};
 
   WGPUAdapter adapter = NULL;
+  bool adapterRequestDone = false;
   wgpuInstanceRequestAdapter(app->instance, &adapterOptions,
                              (WGPURequestAdapterCallbackInfo){
                                  .mode = WGPUCallbackMode_AllowProcessEvents,
                                  .callback = OnAdapterRequestEnded,
                                  .userdata1 = &adapter,
+                                 .userdata2 = &adapterRequestDone,
                              });
 
   // 等待适配器请求完成
-  while (!adapter) {
+  while (!adapterRequestDone) {
     wgpuInstanceProcessEvents(app->instance);
   }
 
@@ -194,15 +217,17 @@ bool InitializeWebGPU(AppContext *app) {
 
   // 请求设备
   WGPUDeviceDescriptor deviceDesc = {0};
+  bool deviceRequestDone = false;
   wgpuAdapterRequestDevice(adapter, &deviceDesc,
                            (WGPURequestDeviceCallbackInfo){
                                .mode = WGPUCallbackMode_AllowProcessEvents,
                                .callback = OnDeviceRequestEnded,
                                .userdata1 = &app->device,
+                               .userdata2 = &deviceRequestDone,
                            });
 
   // 等待设备请求完成
-  while (!app->device) {
+  while (!deviceRequestDone) {
     wgpuInstanceProcessEvents(app->instance);
   }
 
@@ -215,6 +240,12 @@ bool InitializeWebGPU(AppContext *app) {
 
   app->queue = wgpuDeviceGetQueue(app->device);
 
+  // 无窗口模式渲染到离屏纹理，无需配置表面
+  if (app->headless) {
+    wgpuAdapterRelease(adapter);
+    return true;
+  }
+
   // 获取表面能力并选择合适的格式
   WGPUSurfaceCapabilities capabilities;
   wgpuSurfaceGetCapabilities(app->surface, adapter, &capabilities);
@@ -489,6 +520,52 @@ void RunApp(AppContext *app) {
   }
 }
 
+// 以PPM格式保存BGRA像素（便于金图比对，不依赖图像库）
+static bool WriteFramePPM(const char *path, const uint8_t *bgra,
+                          uint32_t width, uint32_t height) {
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return false;
+
+  fprintf(file, "P6\n%u %u\n255\n", width, height);
+  for (size_t i = 0; i < (size_t)width * height; i++) {
+    const uint8_t rgb[3] = {bgra[i * 4 + 2], bgra[i * 4 + 1], bgra[i * 4]};
+    fwrite(rgb, 1, 3, file);
+  }
+
+  fclose(file);
+  return true;
+}
+
+// 无窗口主循环：不做帧同步，连续渲染指定帧数到离屏纹理
+void RunHeadless(AppContext *app) {
+  for (int frame = 0; frame < app->headlessFrames; frame++) {
+    Clay_SetLayoutDimensions(
+        (Clay_Dimensions){app->windowWidth, app->windowHeight});
+    Clay_SetPointerState((Clay_Vector2){0, 0}, false);
+    Clay_UpdateScrollContainers(true, (Clay_Vector2){0, 0}, 0.016f);
+
+    CreateAppLayout(app);
+    Clay_RenderCommandArray renderCommands = Clay_EndLayout();
+    Clay_WebGPU_Render(app->clayRenderer, renderCommands);
+
+    wgpuDevicePoll(app->device, false, NULL);
+  }
+
+  if (app->dumpPath) {
+    size_t size = (size_t)app->windowWidth * app->windowHeight * 4;
+    uint8_t *pixels = malloc(size);
+    if (pixels && Clay_WebGPU_ReadPixels(app->clayRenderer, pixels) &&
+        WriteFramePPM(app->dumpPath, pixels, app->windowWidth,
+                      app->windowHeight)) {
+      Log("已保存离屏帧: %s\n", app->dumpPath);
+    } else {
+      Log("保存离屏帧失败: %s\n", app->dumpPath);
+    }
+    free(pixels);
+  }
+}
+
 // 清理资源
 void CleanupApp(AppContext *app) {
   // 首先等待所有GPU操作完成
@@ -532,43 +609,73 @@ void CleanupApp(AppContext *app) {
     app->window = NULL;
   }
 
-  glfwTerminate();
+  if (!app->headless)
+    glfwTerminate();
 }
 
 // 主函数
-int main() {
+// 参数: --headless [--frames N] [--software] [--dump frame.ppm]
+//       [--size WIDTHxHEIGHT] [--sdf]
+int main(int argc, char **argv) {
   SetupLogging(); // 设置日志记录
 
   AppContext app = {0};
   app.windowWidth = 1200;
   app.windowHeight = 800;
-
-  // 初始化GLFW
-  if (!glfwInit()) {
-    Log("Failed to initialize GLFW\n");
-    return -1;
+  app.headlessFrames = 1;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--headless") == 0) {
+      app.headless = true;
+    } else if (strcmp(argv[i], "--software") == 0) {
+      app.softwareAdapter = true;
+    } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      app.headlessFrames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+      app.dumpPath = argv[++i];
+    } else if (strcmp(argv[i], "--sdf") == 0) {
+      app.sdfText = true;
+    } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      unsigned int width, height;
+      if (sscanf(argv[++i], "%ux%u", &width, &height) == 2 && width > 0 &&
+          height > 0) {
+        app.windowWidth = width;
+        app.windowHeight = height;
+      }
+    }
   }
 
-  // 创建窗口
-  glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-  glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
-  app.window = glfwCreateWindow(app.windowWidth, app.windowHeight,
-                                "Clay Native App with WebGPU", NULL, NULL);
+  if (!app.headless) {
+    // 初始化GLFW
+    if (!glfwInit()) {
+      Log("Failed to initialize GLFW\n");
+      RestoreConsole();
+      return -1;
+    }
 
-  if (!app.window) {
-    Log("Failed to create window\n");
-    glfwTerminate();
-    return -1;
-  }
+    // 创建窗口
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    app.window = glfwCreateWindow(app.windowWidth, app.windowHeight,
+                                  "Clay Native App with WebGPU", NULL, NULL);
+
+    if (!app.window) {
+      Log("Failed to create window\n");
+      glfwTerminate();
+      RestoreConsole();
+      return -1;
+    }
 
-  // 设置窗口用户指针和回调
-  glfwSetWindowUserPointer(app.window, &app);
-  glfwSetWindowSizeCallback(app.window, WindowResizeCallback);
+    // 设置窗口用户指针和回调
+    glfwSetWindowUserPointer(app.window, &app);
+    glfwSetWindowSizeCallback(app.window, WindowResizeCallback);
+  }
 
   // 初始化WebGPU
   if (!InitializeWebGPU(&app)) {
     Log("Failed to initialize WebGPU\n");
     CleanupApp(&app);
+    RestoreConsole();
     return -1;
   }
 
@@ -590,6 +697,17 @@ int main() {
     RestoreConsole();
     return -1;
   }
+  Clay_WebGPU_SetTextSdfMode(app.clayRenderer, app.sdfText);
+  // 无窗口模式用于金图回归，每一帧都要完整，字形同步光栅化
+  Clay_WebGPU_SetTextAsyncRaster(app.clayRenderer, !app.headless);
+
+  if (app.headless && !Clay_WebGPU_CreateOffscreenTarget(
+                          app.clayRenderer, app.windowWidth, app.windowHeight)) {
+    Log("Failed to create offscreen render target\n");
+    CleanupApp(&app);
+    RestoreConsole();
+    return -1;
+  }
 
   // 使用新的文本渲染系统加载字体 - 优先加载支持中文的字体
   Log("=== 开始加载字体 ===\n");
@@ -637,23 +755,24 @@ int main() {
   };
 
   bool fontLoaded = false;
-  for (int i = 0; fontPaths[i] != NULL; i++) {
-    // 检查文件是否存在
-    FILE *testFile = fopen(fontPaths[i], "rb");
-    if (testFile) {
-      fclose(testFile);
-      Log("字体文件存在: %s\n", fontPaths[i]);
-
-      if (Clay_WebGPU_LoadFont(app.clayRenderer, fontPaths[i], 16)) {
-        Log("✓ 成功加载字体: %s\n", fontPaths[i]);
-        fontLoaded = true;
-        break;
-      } else {
-        Log("✗ 无法加载字体: %s (文件存在但加载失败)\n", fontPaths[i]);
-      }
-    } else {
-      Log("字体文件不存在: %s\n", fontPaths[i]);
+  int fallbackCount = 0;
+  for (int i = 0; fontPaths[i] != NULL && fallbackCount < MAX_FALLBACK_FONTS;
+       i++) {
+    // 第一个可用字体作为默认字体，其后可用的字体依次加入回退链
+    // 文件只映射不读取、字体表首次使用时才解析，多加载几个字体几乎没有开销
+    if (fontLoaded) {
+      if (Clay_WebGPU_LoadFallbackFont(app.clayRenderer, fontPaths[i], 16))
+        fallbackCount++;
+      continue;
     }
+
+    // 直接尝试加载：不存在或无效时加载失败
+    if (Clay_WebGPU_LoadFont(app.clayRenderer, fontPaths[i], 16)) {
+      Log("✓ 成功加载字体: %s\n", fontPaths[i]);
+      fontLoaded = true;
+      continue;
+    }
+    Log("✗ 无法加载字体: %s\n", fontPaths[i]);
   }
 
   if (!fontLoaded) {
@@ -688,8 +807,18 @@ int main() {
     }
   }
 
+  // 窗口模式复用上次运行的字形缓存；无窗口模式每次从空图集开始，结果可复现
+  if (!app.headless && fontLoaded) {
+    Clay_WebGPU_LoadTextCache(app.clayRenderer, GLYPH_CACHE_PATH);
+  }
+
   // 运行应用
-  RunApp(&app);
+  if (app.headless) {
+    RunHeadless(&app);
+  } else {
+    RunApp(&app);
+    Clay_WebGPU_SaveTextCache(app.clayRenderer, GLYPH_CACHE_PATH);
+  }
 
   // 清理资源
   CleanupApp(&app);
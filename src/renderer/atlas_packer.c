@@ -0,0 +1,201 @@
+// atlas_packer.c - 按高度分桶的行（shelf）矩形装箱器实现
+#include "atlas_packer.h"
+#include <string.h>
+
+static int round_up_to_bucket(int height) {
+  return (height + ATLAS_PACKER_SHELF_GRANULARITY - 1) /
+         ATLAS_PACKER_SHELF_GRANULARITY * ATLAS_PACKER_SHELF_GRANULARITY;
+}
+
+static void reset_shelf_spans(AtlasPacker *packer, AtlasPackerShelf *shelf) {
+  shelf->free_spans[0] = (AtlasPackerSpan){0, packer->width};
+  shelf->free_span_count = 1;
+  shelf->used_count = 0;
+}
+
+void atlas_packer_init(AtlasPacker *packer, int width, int height) {
+  memset(packer, 0, sizeof(AtlasPacker));
+  packer->width = width;
+  packer->height = height;
+}
+
+void atlas_packer_reset(AtlasPacker *packer) {
+  atlas_packer_init(packer, packer->width, packer->height);
+}
+
+// 在已有的行中寻找最合适的空闲区间：优先行高浪费最少，其次区间剩余最少
+// 行高不超过需求的1.5倍，避免小字形占用大行；空行不受此限制
+static bool find_free_span(AtlasPacker *packer, int padded_width, int bucket,
+                           int *out_shelf, int *out_span) {
+  int64_t best_score = -1;
+
+  for (int i = 0; i < packer->shelf_count; i++) {
+    AtlasPackerShelf *shelf = &packer->shelves[i];
+    if (shelf->height < bucket)
+      continue;
+    if (shelf->used_count > 0 && shelf->height > bucket + bucket / 2)
+      continue;
+
+    for (int j = 0; j < shelf->free_span_count; j++) {
+      int leftover = shelf->free_spans[j].width - padded_width;
+      if (leftover < 0)
+        continue;
+
+      int64_t score =
+          (int64_t)(shelf->height - bucket) * packer->width + leftover;
+      if (best_score < 0 || score < best_score) {
+        best_score = score;
+        *out_shelf = i;
+        *out_span = j;
+      }
+    }
+  }
+
+  return best_score >= 0;
+}
+
+bool atlas_packer_alloc(AtlasPacker *packer, int width, int height,
+                        AtlasPackerRect *out_rect, int *out_shelf) {
+  int padded_width = width + ATLAS_PACKER_PADDING;
+  int bucket = round_up_to_bucket(height + ATLAS_PACKER_PADDING);
+  if (width <= 0 || height <= 0 || padded_width > packer->width ||
+      bucket > packer->height)
+    return false;
+
+  int shelf_index = -1;
+  int span_index = -1;
+
+  if (!find_free_span(packer, padded_width, bucket, &shelf_index,
+                      &span_index)) {
+    // 现有行放不下：从未划分区域开一个新行
+    if (packer->shelf_count >= ATLAS_PACKER_MAX_SHELVES ||
+        packer->next_shelf_y + bucket > packer->height)
+      return false;
+
+    shelf_index = packer->shelf_count++;
+    span_index = 0;
+    AtlasPackerShelf *shelf = &packer->shelves[shelf_index];
+    shelf->y = packer->next_shelf_y;
+    shelf->height = bucket;
+    reset_shelf_spans(packer, shelf);
+    packer->next_shelf_y += bucket;
+  }
+
+  AtlasPackerShelf *shelf = &packer->shelves[shelf_index];
+  AtlasPackerSpan *span = &shelf->free_spans[span_index];
+
+  *out_rect = (AtlasPackerRect){span->x, shelf->y, width, height};
+  *out_shelf = shelf_index;
+
+  // 从区间左侧切出，区间用完时移除
+  span->x += padded_width;
+  span->width -= padded_width;
+  if (span->width == 0) {
+    memmove(span, span + 1,
+            (shelf->free_span_count - span_index - 1) * sizeof(AtlasPackerSpan));
+    shelf->free_span_count--;
+  }
+
+  shelf->used_count++;
+  packer->allocated_count++;
+  packer->allocated_area += (int64_t)width * height;
+  return true;
+}
+
+void atlas_packer_free(AtlasPacker *packer, AtlasPackerRect rect, int shelf) {
+  if (shelf < 0 || shelf >= packer->shelf_count)
+    return;
+
+  AtlasPackerShelf *target = &packer->shelves[shelf];
+  packer->allocated_count--;
+  packer->allocated_area -= (int64_t)rect.width * rect.height;
+
+  if (--target->used_count <= 0) {
+    // 整行空闲：恢复为一个完整区间；位于末尾的空行归还给未划分区域
+    reset_shelf_spans(packer, target);
+    while (packer->shelf_count > 0 &&
+           packer->shelves[packer->shelf_count - 1].used_count == 0) {
+      packer->shelf_count--;
+      packer->next_shelf_y = packer->shelves[packer->shelf_count].y;
+    }
+    return;
+  }
+
+  AtlasPackerSpan freed = {rect.x, rect.width + ATLAS_PACKER_PADDING};
+
+  // 按 x 有序插入，并与左右相邻区间合并
+  int insert = 0;
+  while (insert < target->free_span_count &&
+         target->free_spans[insert].x < freed.x) {
+    insert++;
+  }
+
+  bool merge_left =
+      insert > 0 && target->free_spans[insert - 1].x +
+                            target->free_spans[insert - 1].width ==
+                        freed.x;
+  bool merge_right = insert < target->free_span_count &&
+                     freed.x + freed.width == target->free_spans[insert].x;
+
+  if (merge_left && merge_right) {
+    target->free_spans[insert - 1].width +=
+        freed.width + target->free_spans[insert].width;
+    memmove(&target->free_spans[insert], &target->free_spans[insert + 1],
+            (target->free_span_count - insert - 1) * sizeof(AtlasPackerSpan));
+    target->free_span_count--;
+  } else if (merge_left) {
+    target->free_spans[insert - 1].width += freed.width;
+  } else if (merge_right) {
+    target->free_spans[insert].x = freed.x;
+    target->free_spans[insert].width += freed.width;
+  } else if (target->free_span_count < ATLAS_PACKER_MAX_SPANS) {
+    memmove(&target->free_spans[insert + 1], &target->free_spans[insert],
+            (target->free_span_count - insert) * sizeof(AtlasPackerSpan));
+    target->free_spans[insert] = freed;
+    target->free_span_count++;
+  }
+  // 区间表已满时该空间暂不回收，整行空闲后统一恢复
+}
+
+bool atlas_packer_is_valid(const AtlasPacker *packer) {
+  if (packer->width <= 0 || packer->height <= 0 ||
+      packer->shelf_count < 0 ||
+      packer->shelf_count > ATLAS_PACKER_MAX_SHELVES ||
+      packer->allocated_count < 0)
+    return false;
+
+  int y = 0;
+  for (int i = 0; i < packer->shelf_count; i++) {
+    const AtlasPackerShelf *shelf = &packer->shelves[i];
+    if (shelf->y != y || shelf->height < ATLAS_PACKER_SHELF_GRANULARITY ||
+        shelf->height % ATLAS_PACKER_SHELF_GRANULARITY != 0 ||
+        shelf->used_count < 0 || shelf->free_span_count < 0 ||
+        shelf->free_span_count > ATLAS_PACKER_MAX_SPANS)
+      return false;
+    y += shelf->height;
+
+    int span_end = 0;
+    for (int j = 0; j < shelf->free_span_count; j++) {
+      AtlasPackerSpan span = shelf->free_spans[j];
+      if (span.x < span_end || span.width <= 0 ||
+          span.width > packer->width - span.x)
+        return false;
+      span_end = span.x + span.width;
+    }
+  }
+
+  // 行按分配顺序首尾相接，末行之后即未划分区域
+  return y == packer->next_shelf_y && y <= packer->height;
+}
+
+bool atlas_packer_contains(const AtlasPacker *packer, AtlasPackerRect rect,
+                           int shelf) {
+  if (shelf < 0 || shelf >= packer->shelf_count)
+    return false;
+
+  const AtlasPackerShelf *target = &packer->shelves[shelf];
+  return target->used_count > 0 && rect.y == target->y && rect.x >= 0 &&
+         rect.width > 0 && rect.height > 0 &&
+         rect.width + ATLAS_PACKER_PADDING <= packer->width - rect.x &&
+         rect.height + ATLAS_PACKER_PADDING <= target->height;
+}
@@ -0,0 +1,63 @@
+// atlas_packer.h - 按高度分桶的行（shelf）矩形装箱器，支持原地回收
+#ifndef ATLAS_PACKER_H
+#define ATLAS_PACKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 配置常量
+#define ATLAS_PACKER_SHELF_GRANULARITY 8 // 行高按此取整分桶
+#define ATLAS_PACKER_MAX_HEIGHT 1024     // 图集（页）高度上限，决定行数上限
+#define ATLAS_PACKER_MAX_SHELVES (ATLAS_PACKER_MAX_HEIGHT / ATLAS_PACKER_SHELF_GRANULARITY)
+#define ATLAS_PACKER_MAX_SPANS 32        // 每行跟踪的空闲区间上限
+#define ATLAS_PACKER_PADDING 1           // 相邻矩形之间的间距（防止线性采样串色）
+
+// 装箱结果中的矩形（像素坐标，不含间距）
+typedef struct {
+    int x, y;
+    int width, height;
+} AtlasPackerRect;
+
+// 行内的空闲区间
+typedef struct {
+    int x;
+    int width;
+} AtlasPackerSpan;
+
+// 一行：高度固定，宽度为整个图集，行内按空闲区间分配
+typedef struct {
+    int y;
+    int height;
+    int used_count; // 行内已分配的矩形数量，为0时整行恢复空闲
+    AtlasPackerSpan free_spans[ATLAS_PACKER_MAX_SPANS];
+    int free_span_count;
+} AtlasPackerShelf;
+
+typedef struct {
+    int width, height;
+    AtlasPackerShelf shelves[ATLAS_PACKER_MAX_SHELVES];
+    int shelf_count;
+    int next_shelf_y; // 尚未划分成行的区域起点
+
+    // 统计信息
+    int allocated_count;
+    int64_t allocated_area;
+} AtlasPacker;
+
+void atlas_packer_init(AtlasPacker *packer, int width, int height);
+void atlas_packer_reset(AtlasPacker *packer);
+
+// 分配 width x height 的矩形，成功时写入 out_rect 与所在行号（释放时使用）
+bool atlas_packer_alloc(AtlasPacker *packer, int width, int height,
+                        AtlasPackerRect *out_rect, int *out_shelf);
+// 归还矩形占用的区间，与相邻空闲区间合并
+void atlas_packer_free(AtlasPacker *packer, AtlasPackerRect rect, int shelf);
+
+// 检查装箱器状态是否自洽（行首尾相接、区间有序且在图集内），
+// 用于从文件恢复的状态，通过后才能交给分配与归还
+bool atlas_packer_is_valid(const AtlasPacker *packer);
+// 检查矩形能否是 shelf 行中分配出的区域
+bool atlas_packer_contains(const AtlasPacker *packer, AtlasPackerRect rect,
+                           int shelf);
+
+#endif // ATLAS_PACKER_H
@@ -0,0 +1,172 @@
+// font_coverage.c - 字体覆盖索引实现
+#include "font_coverage.h"
+#include <stdlib.h>
+#include <string.h>
+
+// cmap 中的整数均为大端序
+static uint16_t read_u16(const unsigned char *p) {
+  return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint32_t read_u32(const unsigned char *p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+         p[3];
+}
+
+static bool set_glyph(FontCoverage *coverage, uint32_t codepoint, int glyph) {
+  if (codepoint >= 0x110000 || glyph <= 0 || glyph > 0xFFFF)
+    return true;
+
+  uint16_t *page = &coverage->page_map[codepoint / FONT_COVERAGE_PAGE_SIZE];
+  if (*page == 0) {
+    void *pages = realloc(coverage->pages, (coverage->page_count + 1) *
+                                               sizeof(*coverage->pages));
+    if (!pages)
+      return false;
+    coverage->pages = pages;
+    memset(coverage->pages[coverage->page_count], 0,
+           sizeof(*coverage->pages));
+    *page = (uint16_t)++coverage->page_count;
+  }
+
+  uint16_t *slot = &coverage->pages[*page - 1][codepoint % FONT_COVERAGE_PAGE_SIZE];
+  if (*slot == 0)
+    coverage->codepoint_count++;
+  *slot = (uint16_t)glyph;
+  return true;
+}
+
+// 格式4：BMP分段映射
+static bool build_format4(FontCoverage *coverage, const unsigned char *table,
+                          const unsigned char *end) {
+  if (table + 14 > end)
+    return false;
+  int seg_count = read_u16(table + 6) / 2;
+  const unsigned char *end_codes = table + 14;
+  const unsigned char *start_codes = end_codes + seg_count * 2 + 2;
+  const unsigned char *deltas = start_codes + seg_count * 2;
+  const unsigned char *range_offsets = deltas + seg_count * 2;
+  if (range_offsets + seg_count * 2 > end)
+    return false;
+
+  for (int i = 0; i < seg_count; i++) {
+    uint32_t start = read_u16(start_codes + i * 2);
+    uint32_t stop = read_u16(end_codes + i * 2);
+    uint16_t delta = read_u16(deltas + i * 2);
+    uint16_t range_offset = read_u16(range_offsets + i * 2);
+
+    for (uint32_t cp = start; cp <= stop && cp != 0xFFFF; cp++) {
+      int glyph;
+      if (range_offset == 0) {
+        glyph = (uint16_t)(cp + delta);
+      } else {
+        const unsigned char *p =
+            range_offsets + i * 2 + range_offset + (cp - start) * 2;
+        if (p + 2 > end)
+          break;
+        glyph = read_u16(p);
+        if (glyph != 0)
+          glyph = (uint16_t)(glyph + delta);
+      }
+      if (!set_glyph(coverage, cp, glyph))
+        return false;
+    }
+  }
+  return true;
+}
+
+// 格式12/13：32位分组映射（13为多对一，整组映射到同一字形）
+static bool build_groups(FontCoverage *coverage, const unsigned char *table,
+                         const unsigned char *end, bool many_to_one) {
+  if (table + 16 > end)
+    return false;
+  uint32_t group_count = read_u32(table + 12);
+  const unsigned char *groups = table + 16;
+  if (group_count > (uint32_t)(end - groups) / 12)
+    return false;
+
+  for (uint32_t i = 0; i < group_count; i++) {
+    const unsigned char *group = groups + i * 12;
+    uint32_t start = read_u32(group);
+    uint32_t stop = read_u32(group + 4);
+    uint32_t glyph = read_u32(group + 8);
+    if (stop >= 0x110000)
+      stop = 0x10FFFF;
+
+    for (uint32_t cp = start; cp <= stop; cp++) {
+      int index = (int)(many_to_one ? glyph : glyph + (cp - start));
+      if (!set_glyph(coverage, cp, index))
+        return false;
+    }
+  }
+  return true;
+}
+
+// 格式0/6：单字节或连续区间的字形数组
+static bool build_array(FontCoverage *coverage, const unsigned char *table,
+                        const unsigned char *end, bool trimmed) {
+  uint32_t first = trimmed ? read_u16(table + 6) : 0;
+  uint32_t count = trimmed ? read_u16(table + 8) : 256;
+  const unsigned char *glyphs = table + (trimmed ? 10 : 6);
+  size_t entry_size = trimmed ? 2 : 1;
+  if (glyphs + count * entry_size > end)
+    return false;
+
+  for (uint32_t i = 0; i < count; i++) {
+    int glyph = trimmed ? read_u16(glyphs + i * 2) : glyphs[i];
+    if (!set_glyph(coverage, first + i, glyph))
+      return false;
+  }
+  return true;
+}
+
+// 逐个码点查询 BMP，只用于无法解析的 cmap 格式
+static bool build_by_probing(FontCoverage *coverage,
+                             const stbtt_fontinfo *info) {
+  for (uint32_t cp = 0; cp < 0x10000; cp++) {
+    if (!set_glyph(coverage, cp, stbtt_FindGlyphIndex(info, (int)cp)))
+      return false;
+  }
+  return true;
+}
+
+bool font_coverage_build(FontCoverage *coverage, const stbtt_fontinfo *info,
+                         size_t data_size) {
+  memset(coverage, 0, sizeof(FontCoverage));
+  if (info->index_map <= 0 || (size_t)info->index_map + 10 > data_size)
+    return build_by_probing(coverage, info);
+
+  // stb_truetype 初始化时已选出 Unicode 子表
+  const unsigned char *table = info->data + info->index_map;
+  const unsigned char *end = info->data + data_size;
+  bool built;
+  switch (read_u16(table)) {
+  case 0:
+    built = build_array(coverage, table, end, false);
+    break;
+  case 4:
+    built = build_format4(coverage, table, end);
+    break;
+  case 6:
+    built = build_array(coverage, table, end, true);
+    break;
+  case 12:
+  case 13:
+    built = build_groups(coverage, table, end, read_u16(table) == 13);
+    break;
+  default:
+    built = false;
+    break;
+  }
+
+  if (!built) {
+    font_coverage_free(coverage);
+    return build_by_probing(coverage, info);
+  }
+  return true;
+}
+
+void font_coverage_free(FontCoverage *coverage) {
+  free(coverage->pages);
+  memset(coverage, 0, sizeof(FontCoverage));
+}
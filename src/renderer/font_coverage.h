@@ -0,0 +1,37 @@
+// font_coverage.h - 字体覆盖索引：码点 -> 字形索引
+// 初始化字体时从 cmap 一次性构建两级表（256码点一页，空页不分配），
+// 回退查找时每个字体只需两次数组访问，不再逐字符遍历 cmap
+#ifndef FONT_COVERAGE_H
+#define FONT_COVERAGE_H
+
+#include "stb_truetype.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FONT_COVERAGE_PAGE_SIZE 256
+#define FONT_COVERAGE_PAGE_COUNT (0x110000 / FONT_COVERAGE_PAGE_SIZE)
+
+typedef struct {
+    uint16_t page_map[FONT_COVERAGE_PAGE_COUNT]; // 页号 + 1，0 表示整页没有字形
+    uint16_t (*pages)[FONT_COVERAGE_PAGE_SIZE];
+    int page_count;
+    int codepoint_count; // 覆盖的码点数
+} FontCoverage;
+
+// data_size 为字体文件大小，用于 cmap 越界检查
+bool font_coverage_build(FontCoverage *coverage, const stbtt_fontinfo *info,
+                         size_t data_size);
+void font_coverage_free(FontCoverage *coverage);
+
+// 返回码点的字形索引，字体不包含该码点时返回 0（.notdef）
+static inline int font_coverage_glyph(const FontCoverage *coverage,
+                                      uint32_t codepoint) {
+    if (codepoint >= 0x110000)
+        return 0;
+    uint16_t page = coverage->page_map[codepoint / FONT_COVERAGE_PAGE_SIZE];
+    return page ? coverage->pages[page - 1][codepoint % FONT_COVERAGE_PAGE_SIZE]
+                : 0;
+}
+
+#endif // FONT_COVERAGE_H
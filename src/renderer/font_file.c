@@ -0,0 +1,120 @@
+// font_file.c - 只读内存映射的字体文件实现
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "font_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 映射不可用时（例如某些网络文件系统）整体读入堆内存
+static bool read_whole_file(FontFile *file, const char *path) {
+  FILE *handle = fopen(path, "rb");
+  if (!handle)
+    return false;
+
+  fseek(handle, 0, SEEK_END);
+  long file_size = ftell(handle);
+  fseek(handle, 0, SEEK_SET);
+
+  unsigned char *buffer = file_size > 0 ? malloc(file_size) : NULL;
+  if (!buffer || fread(buffer, 1, file_size, handle) != (size_t)file_size) {
+    free(buffer);
+    fclose(handle);
+    return false;
+  }
+  fclose(handle);
+
+  file->data = buffer;
+  file->size = (size_t)file_size;
+  file->mapped = false;
+  return true;
+}
+
+static bool map_whole_file(FontFile *file, const char *path) {
+#ifdef _WIN32
+  HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (handle == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart <= 0) {
+    CloseHandle(handle);
+    return false;
+  }
+
+  // 映射对象持有文件引用，文件句柄可以立即关闭
+  HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(handle);
+  if (!mapping)
+    return false;
+
+  const unsigned char *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    CloseHandle(mapping);
+    return false;
+  }
+
+  file->data = data;
+  file->size = (size_t)file_size.QuadPart;
+  file->mapping_handle = mapping;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+
+  // 映射保持文件引用，描述符可以立即关闭
+  void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+
+  file->data = data;
+  file->size = (size_t)info.st_size;
+#endif
+  file->mapped = true;
+  return true;
+}
+
+bool font_file_open(FontFile *file, const char *path) {
+  memset(file, 0, sizeof(FontFile));
+  if (!map_whole_file(file, path) && !read_whole_file(file, path))
+    return false;
+
+  strncpy(file->path, path, sizeof(file->path) - 1);
+  file->ref_count = 1;
+  return true;
+}
+
+void font_file_close(FontFile *file) {
+  if (!file->data)
+    return;
+
+  if (!file->mapped) {
+    free((void *)file->data);
+  } else {
+#ifdef _WIN32
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping_handle);
+#else
+    munmap((void *)file->data, file->size);
+#endif
+  }
+  memset(file, 0, sizeof(FontFile));
+}
@@ -0,0 +1,23 @@
+// font_file.h - 只读内存映射的字体文件
+// 同一文件的所有字体（TTC中的各个face、各个字号）共享一份映射，按引用计数释放
+#ifndef FONT_FILE_H
+#define FONT_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    char path[256];
+    const unsigned char *data;
+    size_t size;
+    int ref_count; // 为0时槽位空闲
+
+    bool mapped;          // false 表示映射失败后退回的堆内存副本
+    void *mapping_handle; // Windows 文件映射对象
+} FontFile;
+
+// 映射整个文件（只读），页面在首次访问时才被读入
+bool font_file_open(FontFile *file, const char *path);
+void font_file_close(FontFile *file);
+
+#endif // FONT_FILE_H
@@ -0,0 +1,143 @@
+// font_kerning.c - 字距调整对表实现
+#include "font_kerning.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const uint32_t hot_ranges[][2] = FONT_KERNING_HOT_RANGES;
+
+static bool reserve_slots(FontKerning *kerning, int pair_count) {
+  // 装载因子不超过 1/2，未命中的探测很快遇到空槽
+  uint32_t capacity = 16;
+  while (capacity < (uint32_t)pair_count * 2)
+    capacity *= 2;
+
+  kerning->slots = calloc(capacity, sizeof(FontKerningPair));
+  if (!kerning->slots)
+    return false;
+  kerning->mask = capacity - 1;
+  return true;
+}
+
+static void insert_pair(FontKerning *kerning, int left, int right,
+                        int advance) {
+  if (left <= 0 || right <= 0 || left > 0xFFFF || right > 0xFFFF ||
+      advance == 0)
+    return;
+
+  uint32_t key = (uint32_t)left << 16 | (uint32_t)right;
+  uint32_t i = font_kerning_hash(key) & kerning->mask;
+  while (kerning->slots[i].key != 0 && kerning->slots[i].key != key)
+    i = (i + 1) & kerning->mask;
+
+  if (kerning->slots[i].key == 0)
+    kerning->pair_count++;
+  kerning->slots[i].key = key;
+  kerning->slots[i].advance = (int16_t)advance;
+  kerning->left_glyphs[left >> 3] |= (uint8_t)(1u << (left & 7));
+}
+
+// 旧式 kern 表：整表读入
+static bool build_from_kern_table(FontKerning *kerning,
+                                  const stbtt_fontinfo *info) {
+  int length = stbtt_GetKerningTableLength(info);
+  if (length <= 0)
+    return reserve_slots(kerning, 0);
+
+  stbtt_kerningentry *entries = malloc(length * sizeof(stbtt_kerningentry));
+  if (!entries)
+    return false;
+  length = stbtt_GetKerningTable(info, entries, length);
+
+  bool reserved = reserve_slots(kerning, length);
+  for (int i = 0; reserved && i < length; i++) {
+    insert_pair(kerning, entries[i].glyph1, entries[i].glyph2,
+                entries[i].advance);
+  }
+  free(entries);
+  return reserved;
+}
+
+// GPOS：对常用码点的字形两两查询
+static bool build_from_gpos(FontKerning *kerning, const stbtt_fontinfo *info,
+                            const FontCoverage *coverage) {
+  int range_count = sizeof(hot_ranges) / sizeof(hot_ranges[0]);
+  int capacity = 0;
+  for (int r = 0; r < range_count; r++)
+    capacity += (int)(hot_ranges[r][1] - hot_ranges[r][0] + 1);
+
+  int *glyphs = malloc(capacity * sizeof(int));
+  uint8_t *seen = calloc(0x10000 / 8, 1);
+  if (!glyphs || !seen) {
+    free(glyphs);
+    free(seen);
+    return false;
+  }
+
+  // 多个码点可能映射到同一字形，去重后再两两查询
+  int glyph_count = 0;
+  for (int r = 0; r < range_count; r++) {
+    for (uint32_t cp = hot_ranges[r][0]; cp <= hot_ranges[r][1]; cp++) {
+      int glyph = font_coverage_glyph(coverage, cp);
+      if (glyph && !(seen[glyph >> 3] & (1u << (glyph & 7)))) {
+        seen[glyph >> 3] |= (uint8_t)(1u << (glyph & 7));
+        glyphs[glyph_count++] = glyph;
+      }
+    }
+  }
+  free(seen);
+
+  // 先收集非零调整再建表，表大小按实际对数决定
+  int pair_capacity = 256, pair_count = 0;
+  int (*pairs)[3] = malloc(pair_capacity * sizeof(*pairs));
+  bool ok = pairs != NULL;
+  for (int a = 0; ok && a < glyph_count; a++) {
+    for (int b = 0; ok && b < glyph_count; b++) {
+      int advance = stbtt_GetGlyphKernAdvance(info, glyphs[a], glyphs[b]);
+      if (advance == 0)
+        continue;
+
+      if (pair_count == pair_capacity) {
+        void *grown = realloc(pairs, pair_capacity * 2 * sizeof(*pairs));
+        if (!grown) {
+          ok = false;
+          break;
+        }
+        pairs = grown;
+        pair_capacity *= 2;
+      }
+      pairs[pair_count][0] = glyphs[a];
+      pairs[pair_count][1] = glyphs[b];
+      pairs[pair_count][2] = advance;
+      pair_count++;
+    }
+  }
+  free(glyphs);
+
+  ok = ok && reserve_slots(kerning, pair_count);
+  for (int i = 0; ok && i < pair_count; i++) {
+    insert_pair(kerning, pairs[i][0], pairs[i][1], pairs[i][2]);
+  }
+  free(pairs);
+  return ok;
+}
+
+bool font_kerning_build(FontKerning *kerning, const stbtt_fontinfo *info,
+                        const FontCoverage *coverage) {
+  memset(kerning, 0, sizeof(FontKerning));
+
+  // 与 stbtt_GetGlyphKernAdvance 一致：有 GPOS 时只使用 GPOS
+  bool built;
+  if (info->gpos)
+    built = build_from_gpos(kerning, info, coverage);
+  else
+    built = build_from_kern_table(kerning, info);
+
+  if (!built)
+    font_kerning_free(kerning);
+  return built;
+}
+
+void font_kerning_free(FontKerning *kerning) {
+  free(kerning->slots);
+  memset(kerning, 0, sizeof(FontKerning));
+}
@@ -0,0 +1,57 @@
+// font_kerning.h - 字距调整对表：（左字形, 右字形）-> 调整量
+// 字体初始化时一次性构建开放寻址哈希表，测量与绘制时每对字符只需一次位图
+// 检查和（有调整时）一次哈希查找，不再逐字符扫描 kern/GPOS 表
+#ifndef FONT_KERNING_H
+#define FONT_KERNING_H
+
+#include "font_coverage.h"
+#include "stb_truetype.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// GPOS 字距只能逐对查询，预先计算这些码点范围内字形两两之间的调整量；
+// 旧式 kern 表则整表读入
+#define FONT_KERNING_HOT_RANGES                                                \
+    {{0x0020, 0x007E}, {0x00A0, 0x017F}, {0x2010, 0x201F}}
+
+typedef struct {
+    uint32_t key;    // (左字形 << 16 | 右字形)，0 表示空槽
+    int16_t advance; // 字体单位
+} FontKerningPair;
+
+typedef struct {
+    FontKerningPair *slots; // 容量为2的幂
+    uint32_t mask;
+    int pair_count;
+    uint8_t left_glyphs[0x10000 / 8]; // 作为左字形出现过的字形（快速排除）
+} FontKerning;
+
+bool font_kerning_build(FontKerning *kerning, const stbtt_fontinfo *info,
+                        const FontCoverage *coverage);
+void font_kerning_free(FontKerning *kerning);
+
+static inline uint32_t font_kerning_hash(uint32_t key) {
+    key ^= key >> 16;
+    key *= 0x7FEB352Du;
+    key ^= key >> 15;
+    return key;
+}
+
+// 返回两个字形之间的调整量（字体单位），没有调整时返回 0
+static inline int font_kerning_advance(const FontKerning *kerning,
+                                       uint32_t left, uint32_t right) {
+    if (left > 0xFFFF || right > 0xFFFF ||
+        !(kerning->left_glyphs[left >> 3] & (1u << (left & 7))))
+        return 0;
+
+    uint32_t key = left << 16 | right;
+    for (uint32_t i = font_kerning_hash(key) & kerning->mask;;
+         i = (i + 1) & kerning->mask) {
+        if (kerning->slots[i].key == key)
+            return kerning->slots[i].advance;
+        if (kerning->slots[i].key == 0)
+            return 0;
+    }
+}
+
+#endif // FONT_KERNING_H
@@ -0,0 +1,289 @@
+// glyph_rasterizer.c - 后台线程池字形光栅化实现
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "glyph_rasterizer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION RasterMutex;
+typedef CONDITION_VARIABLE RasterCondition;
+typedef HANDLE RasterThread;
+#else
+typedef pthread_mutex_t RasterMutex;
+typedef pthread_cond_t RasterCondition;
+typedef pthread_t RasterThread;
+#endif
+
+// 任务队列与结果队列共用一把锁：任务量为每帧数十到数百个，锁竞争可以忽略
+// 在途任务不超过 GLYPH_RASTER_QUEUE_SIZE，因此结果队列不会溢出
+struct GlyphRasterizer {
+  GlyphRasterJob jobs[GLYPH_RASTER_QUEUE_SIZE];
+  unsigned long job_head; // 下一个写入位置（单调递增）
+  unsigned long job_tail; // 下一个待处理位置
+
+  GlyphRasterResult results[GLYPH_RASTER_QUEUE_SIZE];
+  unsigned long result_head;
+  unsigned long result_tail;
+
+  int in_flight; // 已提交但尚未取回的任务数
+
+  RasterMutex mutex;
+  RasterCondition condition;
+  RasterThread threads[GLYPH_RASTER_MAX_WORKERS];
+  int thread_count;
+  bool running;
+};
+
+static void raster_lock(GlyphRasterizer *rasterizer) {
+#ifdef _WIN32
+  EnterCriticalSection(&rasterizer->mutex);
+#else
+  pthread_mutex_lock(&rasterizer->mutex);
+#endif
+}
+
+static void raster_unlock(GlyphRasterizer *rasterizer) {
+#ifdef _WIN32
+  LeaveCriticalSection(&rasterizer->mutex);
+#else
+  pthread_mutex_unlock(&rasterizer->mutex);
+#endif
+}
+
+static void raster_signal(GlyphRasterizer *rasterizer) {
+#ifdef _WIN32
+  WakeConditionVariable(&rasterizer->condition);
+#else
+  pthread_cond_signal(&rasterizer->condition);
+#endif
+}
+
+static void raster_broadcast(GlyphRasterizer *rasterizer) {
+#ifdef _WIN32
+  WakeAllConditionVariable(&rasterizer->condition);
+#else
+  pthread_cond_broadcast(&rasterizer->condition);
+#endif
+}
+
+static void raster_wait(GlyphRasterizer *rasterizer) {
+#ifdef _WIN32
+  SleepConditionVariableCS(&rasterizer->condition, &rasterizer->mutex,
+                           INFINITE);
+#else
+  pthread_cond_wait(&rasterizer->condition, &rasterizer->mutex);
+#endif
+}
+
+static int cpu_count(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (int)count : 1;
+#else
+  return 1;
+#endif
+}
+
+void glyph_rasterizer_rasterize(const GlyphRasterJob *job, unsigned char *dest,
+                                int stride) {
+  if (!job->sdf) {
+    stbtt_MakeGlyphBitmap(job->font_info, dest, job->width, job->height, stride,
+                          job->scale, job->scale, (int)job->glyph_index);
+    return;
+  }
+
+  int width = 0, height = 0, xoff = 0, yoff = 0;
+  unsigned char *sdf = stbtt_GetGlyphSDF(
+      job->font_info, job->scale, (int)job->glyph_index, job->sdf_padding,
+      job->sdf_on_edge, (float)job->sdf_on_edge / job->sdf_padding, &width,
+      &height, &xoff, &yoff);
+  if (!sdf)
+    return;
+
+  // 尺寸与预先计算的一致，取交集以防万一
+  int copy_width = width < job->width ? width : job->width;
+  int copy_height = height < job->height ? height : job->height;
+  for (int y = 0; y < copy_height; y++) {
+    memcpy(dest + y * stride, sdf + y * width, copy_width);
+  }
+  stbtt_FreeSDF(sdf, NULL);
+}
+
+// 工作线程：取任务 -> 在锁外光栅化到暂存块 -> 放入结果队列
+static void raster_worker_loop(GlyphRasterizer *rasterizer) {
+  raster_lock(rasterizer);
+  for (;;) {
+    while (rasterizer->running &&
+           rasterizer->job_head == rasterizer->job_tail) {
+      raster_wait(rasterizer);
+    }
+    if (!rasterizer->running)
+      break;
+
+    GlyphRasterJob job =
+        rasterizer->jobs[rasterizer->job_tail % GLYPH_RASTER_QUEUE_SIZE];
+    rasterizer->job_tail++;
+    raster_unlock(rasterizer);
+
+    unsigned char *pixels = calloc((size_t)job.width * job.height, 1);
+    if (pixels)
+      glyph_rasterizer_rasterize(&job, pixels, job.width);
+
+    raster_lock(rasterizer);
+    rasterizer->results[rasterizer->result_head % GLYPH_RASTER_QUEUE_SIZE] =
+        (GlyphRasterResult){job, pixels};
+    rasterizer->result_head++;
+  }
+  raster_unlock(rasterizer);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI raster_thread_main(LPVOID param) {
+  raster_worker_loop(param);
+  return 0;
+}
+#else
+static void *raster_thread_main(void *param) {
+  raster_worker_loop(param);
+  return NULL;
+}
+#endif
+
+GlyphRasterizer *glyph_rasterizer_create(int worker_count) {
+  if (worker_count <= 0)
+    worker_count = cpu_count() - 1; // 给渲染线程留一个核
+  if (worker_count < 1)
+    worker_count = 1;
+  if (worker_count > GLYPH_RASTER_MAX_WORKERS)
+    worker_count = GLYPH_RASTER_MAX_WORKERS;
+
+  GlyphRasterizer *rasterizer = calloc(1, sizeof(GlyphRasterizer));
+  if (!rasterizer)
+    return NULL;
+
+#ifdef _WIN32
+  InitializeCriticalSection(&rasterizer->mutex);
+  InitializeConditionVariable(&rasterizer->condition);
+#else
+  pthread_mutex_init(&rasterizer->mutex, NULL);
+  pthread_cond_init(&rasterizer->condition, NULL);
+#endif
+  rasterizer->running = true;
+
+  for (int i = 0; i < worker_count; i++) {
+#ifdef _WIN32
+    rasterizer->threads[i] =
+        CreateThread(NULL, 0, raster_thread_main, rasterizer, 0, NULL);
+    bool created = rasterizer->threads[i] != NULL;
+#else
+    bool created = pthread_create(&rasterizer->threads[i], NULL,
+                                  raster_thread_main, rasterizer) == 0;
+#endif
+    if (!created)
+      break;
+    rasterizer->thread_count++;
+  }
+
+  // 一个线程都没有启动成功时交由调用方走同步路径
+  if (rasterizer->thread_count == 0) {
+    glyph_rasterizer_destroy(rasterizer);
+    return NULL;
+  }
+  return rasterizer;
+}
+
+void glyph_rasterizer_destroy(GlyphRasterizer *rasterizer) {
+  if (!rasterizer)
+    return;
+
+  raster_lock(rasterizer);
+  rasterizer->running = false;
+  raster_broadcast(rasterizer);
+  raster_unlock(rasterizer);
+
+  for (int i = 0; i < rasterizer->thread_count; i++) {
+#ifdef _WIN32
+    WaitForSingleObject(rasterizer->threads[i], INFINITE);
+    CloseHandle(rasterizer->threads[i]);
+#else
+    pthread_join(rasterizer->threads[i], NULL);
+#endif
+  }
+
+#ifdef _WIN32
+  DeleteCriticalSection(&rasterizer->mutex);
+#else
+  pthread_cond_destroy(&rasterizer->condition);
+  pthread_mutex_destroy(&rasterizer->mutex);
+#endif
+
+  // 未取回的结果
+  for (; rasterizer->result_tail != rasterizer->result_head;
+       rasterizer->result_tail++) {
+    free(rasterizer->results[rasterizer->result_tail % GLYPH_RASTER_QUEUE_SIZE]
+             .pixels);
+  }
+  free(rasterizer);
+}
+
+bool glyph_rasterizer_submit(GlyphRasterizer *rasterizer,
+                             const GlyphRasterJob *job) {
+  if (!rasterizer || !job)
+    return false;
+
+  raster_lock(rasterizer);
+  if (rasterizer->in_flight >= GLYPH_RASTER_QUEUE_SIZE) {
+    raster_unlock(rasterizer);
+    return false;
+  }
+  rasterizer->jobs[rasterizer->job_head % GLYPH_RASTER_QUEUE_SIZE] = *job;
+  rasterizer->job_head++;
+  rasterizer->in_flight++;
+  raster_signal(rasterizer);
+  raster_unlock(rasterizer);
+  return true;
+}
+
+bool glyph_rasterizer_poll(GlyphRasterizer *rasterizer,
+                           GlyphRasterResult *result) {
+  if (!rasterizer || !result)
+    return false;
+
+  raster_lock(rasterizer);
+  bool available = rasterizer->result_tail != rasterizer->result_head;
+  if (available) {
+    *result =
+        rasterizer->results[rasterizer->result_tail % GLYPH_RASTER_QUEUE_SIZE];
+    rasterizer->result_tail++;
+    rasterizer->in_flight--;
+  }
+  raster_unlock(rasterizer);
+  return available;
+}
+
+int glyph_rasterizer_in_flight(GlyphRasterizer *rasterizer) {
+  if (!rasterizer)
+    return 0;
+
+  raster_lock(rasterizer);
+  int in_flight = rasterizer->in_flight;
+  raster_unlock(rasterizer);
+  return in_flight;
+}
+
+int glyph_rasterizer_worker_count(GlyphRasterizer *rasterizer) {
+  return rasterizer ? rasterizer->thread_count : 0;
+}
@@ -0,0 +1,58 @@
+// glyph_rasterizer.h - 后台线程池字形光栅化
+// 渲染线程提交任务，工作线程把字形光栅化到独立的暂存块，
+// 渲染线程在下一帧开始时取回结果并写入图集
+#ifndef GLYPH_RASTERIZER_H
+#define GLYPH_RASTERIZER_H
+
+#include "stb_truetype.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// 配置常量
+#define GLYPH_RASTER_MAX_WORKERS 4    // 工作线程数上限（实际为CPU核数-1）
+#define GLYPH_RASTER_QUEUE_SIZE 4096  // 在途任务上限（已提交但尚未取回）
+
+// 光栅化任务：尺寸由渲染线程预先计算（用于分配图集区域）
+typedef struct {
+    const stbtt_fontinfo *font_info; // 字体在渲染器销毁前保持有效
+    uint32_t glyph_index;
+    float scale;
+    bool sdf;           // 生成距离场（尺寸已包含留白）
+    int sdf_padding;
+    unsigned char sdf_on_edge;
+    int width, height;  // 目标尺寸
+
+    // 渲染线程用于匹配缓存条目的键
+    uint32_t job_id;
+    int font_id;
+    int pixel_size;
+} GlyphRasterJob;
+
+// 完成的任务：pixels 为 width x height 的暂存块，由调用方 free
+// 分配失败时为 NULL，调用方需同步光栅化
+typedef struct {
+    GlyphRasterJob job;
+    unsigned char *pixels;
+} GlyphRasterResult;
+
+typedef struct GlyphRasterizer GlyphRasterizer;
+
+// worker_count <= 0 时按CPU核数自动选择，失败返回 NULL
+GlyphRasterizer *glyph_rasterizer_create(int worker_count);
+// 停止工作线程，未取回的结果随之释放
+void glyph_rasterizer_destroy(GlyphRasterizer *rasterizer);
+
+// 提交任务，在途任务达到上限时返回 false（调用方同步光栅化）
+bool glyph_rasterizer_submit(GlyphRasterizer *rasterizer,
+                             const GlyphRasterJob *job);
+// 取回一个已完成的任务，没有时返回 false（不阻塞）
+bool glyph_rasterizer_poll(GlyphRasterizer *rasterizer,
+                           GlyphRasterResult *result);
+int glyph_rasterizer_in_flight(GlyphRasterizer *rasterizer);
+int glyph_rasterizer_worker_count(GlyphRasterizer *rasterizer);
+
+// 把任务描述的字形光栅化到 dest（行跨度 stride），工作线程与同步路径共用
+void glyph_rasterizer_rasterize(const GlyphRasterJob *job, unsigned char *dest,
+                                int stride);
+
+#endif // GLYPH_RASTERIZER_H
@@ -0,0 +1,170 @@
+// glyph_table.c - 字形缓存索引实现
+#include "glyph_table.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GLYPH_TABLE_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GLYPH_TABLE_NEON 1
+#endif
+
+#define GLYPH_TABLE_ALIGNMENT (GLYPH_TABLE_GROUP * sizeof(uint64_t))
+
+static uint32_t hash_key(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xFF51AFD7ED558CCDull;
+  key ^= key >> 33;
+  return (uint32_t)key;
+}
+
+static int lowest_bit(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(mask);
+#else
+  int index = 0;
+  while (!(mask & 1u)) {
+    mask >>= 1;
+    index++;
+  }
+  return index;
+#endif
+}
+
+// 比较一组键：match 为等于 key 的位置，empty 为空槽位置（每个位置一位）
+static void match_group(const uint64_t *keys, uint64_t key, unsigned *match,
+                        unsigned *empty) {
+  unsigned found = 0, vacant = 0;
+#if defined(GLYPH_TABLE_SSE2)
+  // SSE2 没有64位相等比较：32位比较后与交换高低半的结果相与
+  __m128i needle = _mm_set_epi32((int)(key >> 32), (int)key, (int)(key >> 32),
+                                 (int)key);
+  __m128i zero = _mm_setzero_si128();
+  for (int i = 0; i < GLYPH_TABLE_GROUP; i += 2) {
+    __m128i pair = _mm_load_si128((const __m128i *)(keys + i));
+    __m128i eq = _mm_cmpeq_epi32(pair, needle);
+    __m128i ez = _mm_cmpeq_epi32(pair, zero);
+    eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    ez = _mm_and_si128(ez, _mm_shuffle_epi32(ez, _MM_SHUFFLE(2, 3, 0, 1)));
+    found |= (unsigned)_mm_movemask_pd(_mm_castsi128_pd(eq)) << i;
+    vacant |= (unsigned)_mm_movemask_pd(_mm_castsi128_pd(ez)) << i;
+  }
+#elif defined(GLYPH_TABLE_NEON)
+  uint64x2_t needle = vdupq_n_u64(key);
+  for (int i = 0; i < GLYPH_TABLE_GROUP; i += 2) {
+    uint64x2_t pair = vld1q_u64(keys + i);
+    uint64x2_t eq = vceqq_u64(pair, needle);
+    uint64x2_t ez = vceqzq_u64(pair);
+    found |= (unsigned)(vgetq_lane_u64(eq, 0) & 1) << i |
+             (unsigned)(vgetq_lane_u64(eq, 1) & 1) << (i + 1);
+    vacant |= (unsigned)(vgetq_lane_u64(ez, 0) & 1) << i |
+              (unsigned)(vgetq_lane_u64(ez, 1) & 1) << (i + 1);
+  }
+#else
+  for (int i = 0; i < GLYPH_TABLE_GROUP; i++) {
+    found |= (unsigned)(keys[i] == key) << i;
+    vacant |= (unsigned)(keys[i] == 0) << i;
+  }
+#endif
+  *match = found;
+  *empty = vacant;
+}
+
+bool glyph_table_init(GlyphTable *table, uint32_t capacity) {
+  memset(table, 0, sizeof(GlyphTable));
+  if (capacity < GLYPH_TABLE_GROUP || (capacity & (capacity - 1)) != 0)
+    return false;
+
+  // 键数组按组对齐，每组恰好占一条缓存行
+  table->block = calloc(1, capacity * sizeof(uint64_t) + GLYPH_TABLE_ALIGNMENT);
+  table->slots = calloc(capacity, sizeof(uint16_t));
+  if (!table->block || !table->slots) {
+    glyph_table_free(table);
+    return false;
+  }
+  uintptr_t address = (uintptr_t)table->block;
+  table->keys = (uint64_t *)((address + GLYPH_TABLE_ALIGNMENT - 1) &
+                             ~(uintptr_t)(GLYPH_TABLE_ALIGNMENT - 1));
+  table->mask = capacity - 1;
+  return true;
+}
+
+void glyph_table_free(GlyphTable *table) {
+  free(table->block);
+  free(table->slots);
+  memset(table, 0, sizeof(GlyphTable));
+}
+
+void glyph_table_clear(GlyphTable *table) {
+  if (table->keys)
+    memset(table->keys, 0, (table->mask + 1) * sizeof(uint64_t));
+  table->count = 0;
+}
+
+// 返回键所在位置，不存在时返回 -1
+static int find_position(const GlyphTable *table, uint64_t key) {
+  uint32_t home = hash_key(key) & table->mask;
+  uint32_t group = home & ~(uint32_t)(GLYPH_TABLE_GROUP - 1);
+  // 首组中 home 之前的空槽属于别的探测序列，不能结束查找
+  unsigned live = ~0u << (home - group);
+
+  for (uint32_t probed = 0; probed <= table->mask;
+       probed += GLYPH_TABLE_GROUP) {
+    unsigned match, empty;
+    match_group(table->keys + group, key, &match, &empty);
+    // 键唯一，组内任何位置匹配都是要找的条目
+    if (match)
+      return (int)(group + lowest_bit(match));
+    if (empty & live)
+      return -1;
+    live = ~0u;
+    group = (group + GLYPH_TABLE_GROUP) & table->mask;
+  }
+  return -1;
+}
+
+int glyph_table_find(const GlyphTable *table, uint64_t key) {
+  int position = find_position(table, key);
+  return position >= 0 ? table->slots[position] : -1;
+}
+
+bool glyph_table_insert(GlyphTable *table, uint64_t key, uint16_t slot) {
+  // 至少保留一个空槽，保证探测能够终止
+  if ((uint32_t)table->count >= table->mask)
+    return false;
+
+  uint32_t index = hash_key(key) & table->mask;
+  while (table->keys[index] != 0)
+    index = (index + 1) & table->mask;
+
+  table->keys[index] = key;
+  table->slots[index] = slot;
+  table->count++;
+  return true;
+}
+
+bool glyph_table_remove(GlyphTable *table, uint64_t key) {
+  int position = find_position(table, key);
+  if (position < 0)
+    return false;
+
+  // 后移删除：后续同簇的键若理想位置不在 (hole, next] 区间内，就前移到 hole
+  uint32_t hole = (uint32_t)position;
+  uint32_t next = (hole + 1) & table->mask;
+  while (table->keys[next] != 0) {
+    uint32_t home = hash_key(table->keys[next]) & table->mask;
+    if (((next - home) & table->mask) >= ((next - hole) & table->mask)) {
+      table->keys[hole] = table->keys[next];
+      table->slots[hole] = table->slots[next];
+      hole = next;
+    }
+    next = (next + 1) & table->mask;
+  }
+
+  table->keys[hole] = 0;
+  table->count--;
+  return true;
+}
@@ -0,0 +1,39 @@
+// glyph_table.h - 字形缓存索引：（字形索引, 字体, 字号）-> 缓存条目槽位
+// 键打包为64位存放在紧凑的键数组中，值（条目槽位）单独存放；
+// 线性探测按8个键（64字节，一条缓存行）一组做SIMD比较，
+// 删除时把同簇后续键前移填补空位，不留墓碑
+#ifndef GLYPH_TABLE_H
+#define GLYPH_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GLYPH_TABLE_GROUP 8 // 一次比较的键数
+
+typedef struct {
+    uint64_t *keys;  // 0 表示空槽，按组对齐
+    uint16_t *slots; // 与 keys 一一对应的条目槽位
+    uint32_t mask;   // 容量 - 1（容量为2的幂且不小于一组）
+    int count;
+    void *block; // keys 所在的原始分配
+} GlyphTable;
+
+bool glyph_table_init(GlyphTable *table, uint32_t capacity);
+void glyph_table_free(GlyphTable *table);
+void glyph_table_clear(GlyphTable *table);
+
+// 打包键：最高位恒为1，保证非零
+static inline uint64_t glyph_table_key(uint32_t glyph_index, int font_id,
+                                       int pixel_size) {
+    return 1ull << 63 | (uint64_t)(pixel_size & 0x7FFFFF) << 40 |
+           (uint64_t)(font_id & 0xFF) << 32 | glyph_index;
+}
+
+// 返回键对应的条目槽位，不存在时返回 -1
+int glyph_table_find(const GlyphTable *table, uint64_t key);
+// 插入不存在的键，表满时返回 false
+bool glyph_table_insert(GlyphTable *table, uint64_t key, uint16_t slot);
+// 删除键，不存在时返回 false
+bool glyph_table_remove(GlyphTable *table, uint64_t key);
+
+#endif // GLYPH_TABLE_H
@@ -0,0 +1,179 @@
+// gpu_ring_buffer.c - 按帧分配的GPU环形缓冲区实现
+#include "gpu_ring_buffer.h"
+#include "../DEV.h"
+#include <string.h>
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static WGPUBuffer create_ring_buffer(GpuRingBuffer *ring, uint64_t capacity) {
+  return wgpuDeviceCreateBuffer(
+      ring->device,
+      &(WGPUBufferDescriptor){
+          .label = {.data = ring->label, .length = WGPU_STRLEN},
+          .usage = ring->usage | WGPUBufferUsage_CopyDst,
+          .size = capacity,
+          .mappedAtCreation = false});
+}
+
+// 队列回调：一帧的GPU工作已完成，其占用的区间可以复用
+static void on_frame_done(WGPUQueueWorkDoneStatus status, void *userdata1,
+                          void *userdata2) {
+  (void)status;
+  (void)userdata2;
+  GpuRingBuffer *ring = (GpuRingBuffer *)userdata1;
+  if (ring->completed_frames < ring->submitted_frames) {
+    ring->completed_frames++;
+  }
+}
+
+bool gpu_ring_init(GpuRingBuffer *ring, WGPUDevice device, WGPUQueue queue,
+                   WGPUBufferUsage usage, uint64_t initial_capacity,
+                   const char *label) {
+  if (!ring)
+    return false;
+
+  memset(ring, 0, sizeof(GpuRingBuffer));
+  ring->device = device;
+  ring->queue = queue;
+  ring->usage = usage;
+  ring->label = label;
+  ring->capacity = align_up(initial_capacity, GPU_RING_ALIGNMENT);
+  ring->buffer = create_ring_buffer(ring, ring->capacity);
+
+  return ring->buffer != NULL;
+}
+
+void gpu_ring_destroy(GpuRingBuffer *ring) {
+  if (!ring)
+    return;
+
+  // 等待在途帧完成，确保回调不会在释放后访问 ring
+  if (ring->device && ring->submitted_frames > ring->completed_frames) {
+    wgpuDevicePoll(ring->device, true, NULL);
+  }
+
+  for (int i = 0; i < ring->retired_count; i++) {
+    wgpuBufferRelease(ring->retired[i]);
+  }
+  ring->retired_count = 0;
+
+  if (ring->buffer) {
+    wgpuBufferRelease(ring->buffer);
+    ring->buffer = NULL;
+  }
+}
+
+void gpu_ring_begin_frame(GpuRingBuffer *ring) {
+  if (!ring || !ring->buffer)
+    return;
+
+  // 在途帧达到上限时才阻塞等待（背压），否则从不等待GPU
+  if (ring->submitted_frames - ring->completed_frames >=
+      GPU_RING_FRAMES_IN_FLIGHT) {
+    wgpuDevicePoll(ring->device, true, NULL);
+    ring->completed_frames = ring->submitted_frames;
+  }
+
+  // 最近完成的帧之前的区间都可以复用
+  if (ring->completed_frames > 0) {
+    ring->tail = ring->frame_end[(ring->completed_frames - 1) %
+                                 GPU_RING_FRAMES_IN_FLIGHT];
+  }
+
+  ring->frame_bytes = 0;
+}
+
+void gpu_ring_end_frame(GpuRingBuffer *ring) {
+  if (!ring || !ring->buffer)
+    return;
+
+  ring->frame_end[ring->submitted_frames % GPU_RING_FRAMES_IN_FLIGHT] =
+      ring->head;
+  ring->submitted_frames++;
+
+  wgpuQueueOnSubmittedWorkDone(
+      ring->queue,
+      (WGPUQueueWorkDoneCallbackInfo){.mode = WGPUCallbackMode_AllowSpontaneous,
+                                      .callback = on_frame_done,
+                                      .userdata1 = ring});
+
+  // 已提交的命令持有旧缓冲区的引用，这里可以安全释放
+  for (int i = 0; i < ring->retired_count; i++) {
+    wgpuBufferRelease(ring->retired[i]);
+  }
+  ring->retired_count = 0;
+}
+
+// 扩容：按2的倍数增长，直到能容纳本帧全部数据的两倍
+static bool grow_ring(GpuRingBuffer *ring, uint64_t required) {
+  // 本帧已记录的分配仍引用旧缓冲区，提交之前不能释放；
+  // 待释放列表已满时放弃扩容，本次分配失败
+  if (ring->retired_count == GPU_RING_MAX_RETIRED) {
+    LOG_WARN("环形缓冲区本帧扩容次数过多: %s\n", ring->label);
+    return false;
+  }
+
+  uint64_t new_capacity = ring->capacity;
+  while (new_capacity < required * 2) {
+    new_capacity *= 2;
+  }
+
+  WGPUBuffer new_buffer = create_ring_buffer(ring, new_capacity);
+  if (!new_buffer) {
+    LOG_ERROR("环形缓冲区扩容失败: %s (%llu 字节)\n", ring->label,
+              (unsigned long long)new_capacity);
+    return false;
+  }
+
+  // 旧缓冲区在提交之后释放
+  ring->retired[ring->retired_count++] = ring->buffer;
+
+  LOG_DEBUG("环形缓冲区扩容: %s %llu -> %llu 字节\n", ring->label,
+            (unsigned long long)ring->capacity,
+            (unsigned long long)new_capacity);
+
+  ring->buffer = new_buffer;
+  ring->capacity = new_capacity;
+  ring->head = 0;
+  ring->tail = 0;
+  memset(ring->frame_end, 0, sizeof(ring->frame_end));
+  ring->grow_count++;
+  return true;
+}
+
+bool gpu_ring_upload(GpuRingBuffer *ring, const void *data, uint64_t size,
+                     GpuRingAllocation *out) {
+  if (!ring || !ring->buffer || !data || size == 0 || (size & 3) != 0)
+    return false;
+
+  uint64_t offset = align_up(ring->head, GPU_RING_ALIGNMENT);
+  uint64_t physical = offset % ring->capacity;
+
+  // 尾部放不下时回绕到缓冲区开头
+  if (physical + size > ring->capacity) {
+    offset += ring->capacity - physical;
+    physical = 0;
+  }
+
+  // 会覆盖GPU仍在使用的区间：扩容而不是等待
+  if (offset + size - ring->tail > ring->capacity) {
+    if (!grow_ring(ring, ring->frame_bytes + size + GPU_RING_ALIGNMENT))
+      return false;
+    offset = 0;
+    physical = 0;
+  }
+
+  wgpuQueueWriteBuffer(ring->queue, ring->buffer, physical, data, size);
+
+  ring->head = offset + size;
+  ring->frame_bytes += size;
+
+  if (out) {
+    out->buffer = ring->buffer;
+    out->offset = physical;
+    out->size = size;
+  }
+  return true;
+}
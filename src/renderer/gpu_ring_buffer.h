@@ -0,0 +1,62 @@
+// gpu_ring_buffer.h - 按帧分配的GPU环形缓冲区
+#ifndef GPU_RING_BUFFER_H
+#define GPU_RING_BUFFER_H
+
+#include <webgpu/wgpu.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// 配置常量
+#define GPU_RING_FRAMES_IN_FLIGHT 3 // 允许同时在GPU上执行的帧数
+#define GPU_RING_ALIGNMENT 256      // 子分配对齐（满足顶点/索引/uniform偏移要求）
+#define GPU_RING_MAX_RETIRED 8      // 单帧内扩容次数上限（旧缓冲区提交后才释放）
+
+// 一次子分配的结果
+typedef struct {
+    WGPUBuffer buffer; // 分配所在的缓冲区（扩容后旧分配仍指向旧缓冲区）
+    uint64_t offset;
+    uint64_t size;
+} GpuRingAllocation;
+
+// 环形缓冲区
+// 偏移使用单调递增的逻辑值，物理偏移 = 逻辑偏移 % capacity
+typedef struct {
+    WGPUDevice device;
+    WGPUQueue queue;
+    WGPUBuffer buffer;
+    WGPUBufferUsage usage;
+    const char *label;
+    uint64_t capacity;
+
+    uint64_t head; // 下一次分配的逻辑偏移
+    uint64_t tail; // GPU仍可能读取的最早逻辑偏移
+
+    // 每个在途帧结束时的 head，按 frame_index % GPU_RING_FRAMES_IN_FLIGHT 存放
+    uint64_t frame_end[GPU_RING_FRAMES_IN_FLIGHT];
+    uint64_t submitted_frames; // 已提交的帧数
+    uint64_t completed_frames; // GPU已完成的帧数（由队列回调递增）
+
+    // 本帧扩容替换下来的缓冲区，提交后释放
+    WGPUBuffer retired[GPU_RING_MAX_RETIRED];
+    int retired_count;
+
+    // 统计信息
+    int grow_count;
+    uint64_t frame_bytes; // 本帧已上传字节数
+} GpuRingBuffer;
+
+// 初始化和清理
+bool gpu_ring_init(GpuRingBuffer *ring, WGPUDevice device, WGPUQueue queue,
+                   WGPUBufferUsage usage, uint64_t initial_capacity,
+                   const char *label);
+void gpu_ring_destroy(GpuRingBuffer *ring);
+
+// 帧管理：begin_frame 在写入数据前调用，end_frame 在 wgpuQueueSubmit 之后调用
+void gpu_ring_begin_frame(GpuRingBuffer *ring);
+void gpu_ring_end_frame(GpuRingBuffer *ring);
+
+// 上传数据到环形缓冲区（size 需为4的倍数），空间不足时按几何倍数扩容
+bool gpu_ring_upload(GpuRingBuffer *ring, const void *data, uint64_t size,
+                     GpuRingAllocation *out);
+
+#endif // GPU_RING_BUFFER_H
@@ -1,38 +1,254 @@
 #include "renderer.h"
 #include "../DEV.h"
+#include <math.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
-// 矩形渲染着色器
+// 矩形渲染着色器（实例化）
+// 每个实例是一个矩形，顶点着色器根据 vertex_index 生成两个三角形
 static const char *vertexShaderWGSL =
-    "struct VertexInput {\n"
-    "    @location(0) position: vec2<f32>,\n"
+    "struct Viewport {\n"
+    "    size: vec2<f32>,\n"
+    "    _pad: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0) var<uniform> viewport: Viewport;\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(0) rect: vec4<f32>,\n"
     "    @location(1) color: vec4<f32>,\n"
+    "    @location(2) cornerRadius: vec4<u32>,\n"
+    "    @location(3) borderWidth: vec4<u32>,\n"
     "}\n"
     "\n"
     "struct VertexOutput {\n"
     "    @builtin(position) position: vec4<f32>,\n"
     "    @location(0) color: vec4<f32>,\n"
+    "    @location(1) localPos: vec2<f32>,\n"
+    "    @location(2) @interpolate(flat) size: vec2<f32>,\n"
+    "    @location(3) @interpolate(flat) cornerRadius: vec4<f32>,\n"
+    "    @location(4) @interpolate(flat) borderWidth: vec4<f32>,\n"
     "}\n"
     "\n"
     "@vertex\n"
-    "fn vs_main(input: VertexInput) -> VertexOutput {\n"
+    "fn vs_main(@builtin(vertex_index) vertexIndex: u32,\n"
+    "           input: InstanceInput) -> VertexOutput {\n"
+    "    // 三角形 (左上, 右上, 左下) (右上, 右下, 左下) 的角点位掩码\n"
+    "    let corner = vec2<f32>(f32((0x1Au >> vertexIndex) & 1u),\n"
+    "                           f32((0x34u >> vertexIndex) & 1u));\n"
+    "    let pixel = input.rect.xy + corner * input.rect.zw;\n"
+    "    let ndc = vec2<f32>(pixel.x / viewport.size.x * 2.0 - 1.0,\n"
+    "                        1.0 - pixel.y / viewport.size.y * 2.0);\n"
     "    var output: VertexOutput;\n"
-    "    output.position = vec4<f32>(input.position, 0.0, 1.0);\n"
+    "    output.position = vec4<f32>(ndc, 0.0, 1.0);\n"
     "    output.color = input.color;\n"
+    "    output.localPos = corner * input.rect.zw;\n"
+    "    output.size = input.rect.zw;\n"
+    "    output.cornerRadius = vec4<f32>(input.cornerRadius);\n"
+    "    output.borderWidth = vec4<f32>(input.borderWidth);\n"
     "    return output;\n"
     "}\n";
 
+// 片段着色器：用有向距离场(SDF)解析地计算圆角填充与变宽圆角边框，
+// 无需额外几何体，边框/圆角与普通矩形同批绘制
 static const char *fragmentShaderWGSL =
     "struct FragmentInput {\n"
     "    @location(0) color: vec4<f32>,\n"
+    "    @location(1) localPos: vec2<f32>,\n"
+    "    @location(2) @interpolate(flat) size: vec2<f32>,\n"
+    "    @location(3) @interpolate(flat) cornerRadius: vec4<f32>,\n"
+    "    @location(4) @interpolate(flat) borderWidth: vec4<f32>,\n"
+    "}\n"
+    "\n"
+    "// 圆角矩形SDF，p 相对中心，r = (左上, 右上, 右下, 左下)\n"
+    "fn roundedBoxSdf(p: vec2<f32>, halfSize: vec2<f32>, r: vec4<f32>) -> f32 {\n"
+    "    let side = select(r.xw, r.yz, p.x > 0.0);\n"
+    "    let radius = min(select(side.x, side.y, p.y > 0.0),\n"
+    "                     min(halfSize.x, halfSize.y));\n"
+    "    let q = abs(p) - halfSize + radius;\n"
+    "    return min(max(q.x, q.y), 0.0) + length(max(q, vec2<f32>(0.0))) - radius;\n"
     "}\n"
     "\n"
     "@fragment\n"
     "fn fs_main(input: FragmentInput) -> @location(0) vec4<f32> {\n"
-    "    return input.color;\n"
+    "    let halfSize = input.size * 0.5;\n"
+    "    let outer = roundedBoxSdf(input.localPos - halfSize, halfSize,\n"
+    "                              input.cornerRadius);\n"
+    "    var coverage = clamp(0.5 - outer, 0.0, 1.0);\n"
+    "\n"
+    "    // 边框实例：减去按边框宽度内缩的内部圆角矩形 (bw = 左, 右, 上, 下)\n"
+    "    let bw = input.borderWidth;\n"
+    "    if (any(bw > vec4<f32>(0.0))) {\n"
+    "        let innerMin = vec2<f32>(bw.x, bw.z);\n"
+    "        let innerMax = input.size - vec2<f32>(bw.y, bw.w);\n"
+    "        let innerHalf = max((innerMax - innerMin) * 0.5, vec2<f32>(0.0));\n"
+    "        let innerRadius = max(input.cornerRadius -\n"
+    "                              vec4<f32>(max(bw.x, bw.z), max(bw.y, bw.z),\n"
+    "                                        max(bw.y, bw.w), max(bw.x, bw.w)),\n"
+    "                              vec4<f32>(0.0));\n"
+    "        let inner = roundedBoxSdf(input.localPos - (innerMin + innerHalf),\n"
+    "                                  innerHalf, innerRadius);\n"
+    "        coverage = coverage * clamp(0.5 + inner, 0.0, 1.0);\n"
+    "    }\n"
+    "\n"
+    "    if (coverage <= 0.0) {\n"
+    "        discard;\n"
+    "    }\n"
+    "    return vec4<f32>(input.color.rgb, input.color.a * coverage);\n"
     "}\n";
 
+// 颜色/尺寸分量压缩到 uint8
+static inline uint8_t PackUnorm8(float value) {
+  if (value <= 0.0f)
+    return 0;
+  if (value >= 255.0f)
+    return 255;
+  return (uint8_t)(value + 0.5f);
+}
+
+static void WriteViewportUniform(Clay_WebGPU_Context *context) {
+  float viewport[4] = {(float)context->screenWidth,
+                       (float)context->screenHeight, 0.0f, 0.0f};
+  wgpuQueueWriteBuffer(context->queue, context->uniformBuffer, 0, viewport,
+                       sizeof(viewport));
+}
+
+// 追加一个矩形实例，容量不足时翻倍增长，返回 NULL 表示内存分配失败
+static Clay_WebGPU_RectInstance *
+PushRectInstance(Clay_WebGPU_Context *context, Clay_BoundingBox bbox,
+                 Clay_Color color, Clay_CornerRadius radius) {
+  if (context->rectInstanceCount >= context->rectInstanceCapacity) {
+    uint32_t newCapacity = context->rectInstanceCapacity * 2;
+    Clay_WebGPU_RectInstance *instances = realloc(
+        context->rectInstances, newCapacity * sizeof(Clay_WebGPU_RectInstance));
+    if (!instances)
+      return NULL;
+    context->rectInstances = instances;
+    context->rectInstanceCapacity = newCapacity;
+  }
+
+  Clay_WebGPU_RectInstance *instance =
+      &context->rectInstances[context->rectInstanceCount++];
+  instance->x = bbox.x;
+  instance->y = bbox.y;
+  instance->width = bbox.width;
+  instance->height = bbox.height;
+  instance->color[0] = PackUnorm8(color.r);
+  instance->color[1] = PackUnorm8(color.g);
+  instance->color[2] = PackUnorm8(color.b);
+  instance->color[3] = PackUnorm8(color.a);
+  instance->cornerRadius[0] = PackUnorm8(radius.topLeft);
+  instance->cornerRadius[1] = PackUnorm8(radius.topRight);
+  instance->cornerRadius[2] = PackUnorm8(radius.bottomRight);
+  instance->cornerRadius[3] = PackUnorm8(radius.bottomLeft);
+  memset(instance->borderWidth, 0, sizeof(instance->borderWidth));
+  return instance;
+}
+
+// 当前生效的裁剪区域（无裁剪时为整个屏幕）
+static Clay_BoundingBox CurrentClip(Clay_WebGPU_Context *context) {
+  if (context->clipDepth > 0)
+    return context->clipStack[context->clipDepth - 1];
+  return (Clay_BoundingBox){0, 0, (float)context->screenWidth,
+                            (float)context->screenHeight};
+}
+
+static bool IsOutsideClip(Clay_BoundingBox box, Clay_BoundingBox clip) {
+  return box.x >= clip.x + clip.width || box.x + box.width <= clip.x ||
+         box.y >= clip.y + clip.height || box.y + box.height <= clip.y;
+}
+
+// 更新当前裁剪矩形：对齐到像素并限制在渲染目标内
+static void UpdateScissor(Clay_WebGPU_Context *context) {
+  Clay_BoundingBox clip = CurrentClip(context);
+  float x0 = floorf(clip.x), y0 = floorf(clip.y);
+  float x1 = ceilf(clip.x + clip.width), y1 = ceilf(clip.y + clip.height);
+  float maxX = (float)context->screenWidth, maxY = (float)context->screenHeight;
+
+  x0 = x0 < 0 ? 0 : (x0 > maxX ? maxX : x0);
+  y0 = y0 < 0 ? 0 : (y0 > maxY ? maxY : y0);
+  x1 = x1 < x0 ? x0 : (x1 > maxX ? maxX : x1);
+  y1 = y1 < y0 ? y0 : (y1 > maxY ? maxY : y1);
+
+  context->currentScissor = (Clay_WebGPU_ScissorRect){
+      (uint32_t)x0, (uint32_t)y0, (uint32_t)(x1 - x0), (uint32_t)(y1 - y0)};
+
+  if (context->clipDepth > 0) {
+    text_renderer_set_clip_rect(context->textRenderer, &clip);
+  } else {
+    text_renderer_set_clip_rect(context->textRenderer, NULL);
+  }
+}
+
+static void PushClip(Clay_WebGPU_Context *context, Clay_BoundingBox box) {
+  Clay_BoundingBox outer = CurrentClip(context);
+  float x0 = fmaxf(box.x, outer.x), y0 = fmaxf(box.y, outer.y);
+  float x1 = fminf(box.x + box.width, outer.x + outer.width);
+  float y1 = fminf(box.y + box.height, outer.y + outer.height);
+  Clay_BoundingBox clip = {x0, y0, fmaxf(x1 - x0, 0), fmaxf(y1 - y0, 0)};
+
+  if (context->clipDepth >= CLAY_WEBGPU_MAX_CLIP_DEPTH) {
+    // 栈顶改为求交后的区域，嵌套内容仍被裁剪；只计数，不占栈位
+    LOG_WARN("警告：裁剪栈溢出，沿用最内层裁剪区域\n");
+    context->clipStack[CLAY_WEBGPU_MAX_CLIP_DEPTH - 1] = clip;
+    context->clipOverflow++;
+  } else {
+    context->clipStack[context->clipDepth++] = clip;
+  }
+  UpdateScissor(context);
+}
+
+static void PopClip(Clay_WebGPU_Context *context) {
+  if (context->clipOverflow > 0)
+    context->clipOverflow--;
+  else if (context->clipDepth > 0)
+    context->clipDepth--;
+  UpdateScissor(context);
+}
+
+static bool ScissorEquals(Clay_WebGPU_ScissorRect a,
+                          Clay_WebGPU_ScissorRect b) {
+  return a.x == b.x && a.y == b.y && a.width == b.width &&
+         a.height == b.height;
+}
+
+// 向绘制列表追加区间，与上一个同类、同裁剪且连续的区间合并
+static void AppendDrawRange(Clay_WebGPU_Context *context,
+                            Clay_WebGPU_DrawType type, uint32_t first,
+                            uint32_t count) {
+  if (count == 0)
+    return;
+
+  if (context->drawRangeCount > 0) {
+    Clay_WebGPU_DrawRange *last =
+        &context->drawRanges[context->drawRangeCount - 1];
+    if (last->type == type && last->first + last->count == first &&
+        ScissorEquals(last->scissor, context->currentScissor)) {
+      last->count += count;
+      return;
+    }
+  }
+
+  if (context->drawRangeCount >= context->drawRangeCapacity) {
+    uint32_t newCapacity = context->drawRangeCapacity * 2;
+    Clay_WebGPU_DrawRange *ranges = realloc(
+        context->drawRanges, newCapacity * sizeof(Clay_WebGPU_DrawRange));
+    if (!ranges) {
+      LOG_ERROR("警告：绘制列表内存分配失败\n");
+      return;
+    }
+    context->drawRanges = ranges;
+    context->drawRangeCapacity = newCapacity;
+  }
+
+  context->drawRanges[context->drawRangeCount++] =
+      (Clay_WebGPU_DrawRange){.type = type,
+                              .first = first,
+                              .count = count,
+                              .scissor = context->currentScissor};
+}
+
 Clay_WebGPU_Context *Clay_WebGPU_Initialize(WGPUDevice device, WGPUQueue queue,
                                             WGPUTextureView targetView,
                                             uint32_t screenWidth,
@@ -51,7 +267,7 @@ Clay_WebGPU_Context *Clay_WebGPU_Initialize(WGPUDevice device, WGPUQueue queue,
   context->textRenderer =
       text_renderer_create(device, queue, screenWidth, screenHeight);
   if (!context->textRenderer) {
-    Log("文本渲染器创建失败\n");
+    LOG_ERROR("文本渲染器创建失败\n");
     free(context);
     return NULL;
   }
@@ -79,20 +295,42 @@ Clay_WebGPU_Context *Clay_WebGPU_Initialize(WGPUDevice device, WGPUQueue queue,
   WGPUShaderModule fragmentShader =
       wgpuDeviceCreateShaderModule(device, &fragmentShaderDesc);
 
-  // 顶点属性配置
-  WGPUVertexAttribute vertexAttributes[2] = {
-      {.format = WGPUVertexFormat_Float32x2, .offset = 0, .shaderLocation = 0},
-      {.format = WGPUVertexFormat_Float32x4, .offset = 8, .shaderLocation = 1}};
-
-  WGPUVertexBufferLayout vertexBufferLayout = {
-      .arrayStride = sizeof(float) * 6, // 2 for position, 4 for color
-      .stepMode = WGPUVertexStepMode_Vertex,
-      .attributeCount = 2,
-      .attributes = vertexAttributes};
+  // 实例属性配置（每个矩形一条记录）
+  WGPUVertexAttribute instanceAttributes[4] = {
+      {.format = WGPUVertexFormat_Float32x4,
+       .offset = offsetof(Clay_WebGPU_RectInstance, x),
+       .shaderLocation = 0},
+      {.format = WGPUVertexFormat_Unorm8x4,
+       .offset = offsetof(Clay_WebGPU_RectInstance, color),
+       .shaderLocation = 1},
+      {.format = WGPUVertexFormat_Uint8x4,
+       .offset = offsetof(Clay_WebGPU_RectInstance, cornerRadius),
+       .shaderLocation = 2},
+      {.format = WGPUVertexFormat_Uint8x4,
+       .offset = offsetof(Clay_WebGPU_RectInstance, borderWidth),
+       .shaderLocation = 3}};
+
+  WGPUVertexBufferLayout instanceBufferLayout = {
+      .arrayStride = sizeof(Clay_WebGPU_RectInstance),
+      .stepMode = WGPUVertexStepMode_Instance,
+      .attributeCount = 4,
+      .attributes = instanceAttributes};
+
+  // 视口尺寸uniform绑定组布局
+  WGPUBindGroupLayoutEntry bindGroupLayoutEntry = {
+      .binding = 0,
+      .visibility = WGPUShaderStage_Vertex,
+      .buffer = {.type = WGPUBufferBindingType_Uniform,
+                 .minBindingSize = 4 * sizeof(float)}};
+
+  context->rectangleBindGroupLayout = wgpuDeviceCreateBindGroupLayout(
+      device, &(WGPUBindGroupLayoutDescriptor){
+                  .entryCount = 1, .entries = &bindGroupLayoutEntry});
 
   // 创建矩形渲染管线布局
-  WGPUPipelineLayoutDescriptor layoutDesc = {.bindGroupLayoutCount = 0,
-                                             .bindGroupLayouts = NULL};
+  WGPUPipelineLayoutDescriptor layoutDesc = {
+      .bindGroupLayoutCount = 1,
+      .bindGroupLayouts = &context->rectangleBindGroupLayout};
   WGPUPipelineLayout pipelineLayout =
       wgpuDeviceCreatePipelineLayout(device, &layoutDesc);
 
@@ -119,7 +357,7 @@ Clay_WebGPU_Context *Clay_WebGPU_Initialize(WGPUDevice device, WGPUQueue queue,
       .vertex = {.module = vertexShader,
                  .entryPoint = {.data = "vs_main", .length = WGPU_STRLEN},
                  .bufferCount = 1,
-                 .buffers = &vertexBufferLayout}};
+                 .buffers = &instanceBufferLayout}};
 
   // 设置片段状态
   pipelineDesc.fragment = &(WGPUFragmentState){
@@ -142,29 +380,49 @@ Clay_WebGPU_Context *Clay_WebGPU_Initialize(WGPUDevice device, WGPUQueue queue,
   context->rectanglePipeline =
       wgpuDeviceCreateRenderPipeline(device, &pipelineDesc);
 
-  // 创建矩形渲染缓冲区（支持多个矩形批处理）
-  context->vertexBuffer = wgpuDeviceCreateBuffer(
-      device,
-      &(WGPUBufferDescriptor){
-          .label = {.data = "Rectangle Vertex Buffer", .length = WGPU_STRLEN},
-          .usage = WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst,
-          .size =
-              1000 * 6 * 6 *
-              sizeof(float), // 支持1000个矩形，每个6顶点，6浮点数(2位置+4颜色)
-          .mappedAtCreation = false});
+  // 释放着色器模块（管线持有所需的引用）
+  wgpuShaderModuleRelease(vertexShader);
+  wgpuShaderModuleRelease(fragmentShader);
+  wgpuPipelineLayoutRelease(pipelineLayout);
+
+  // 创建矩形实例环形缓冲区（按帧子分配，溢出时自动扩容）
+  gpu_ring_init(&context->instanceRing, device, queue, WGPUBufferUsage_Vertex,
+                CLAY_WEBGPU_RECT_RING_SIZE, "Rectangle Instance Ring");
 
-  context->indexBuffer = wgpuDeviceCreateBuffer(
+  context->uniformBuffer = wgpuDeviceCreateBuffer(
       device,
       &(WGPUBufferDescriptor){
-          .label = {.data = "Rectangle Index Buffer", .length = WGPU_STRLEN},
-          .usage = WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst,
-          .size = 1000 * 6 * sizeof(uint32_t), // 支持1000个矩形
+          .label = {.data = "Rectangle Viewport Uniform",
+                    .length = WGPU_STRLEN},
+          .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+          .size = 4 * sizeof(float),
           .mappedAtCreation = false});
 
-  // 释放着色器模块
-  wgpuShaderModuleRelease(vertexShader);
-  wgpuShaderModuleRelease(fragmentShader);
-  wgpuPipelineLayoutRelease(pipelineLayout);
+  context->rectangleBindGroup = wgpuDeviceCreateBindGroup(
+      device, &(WGPUBindGroupDescriptor){
+                  .label = {.data = "Rectangle Bind Group",
+                            .length = WGPU_STRLEN},
+                  .layout = context->rectangleBindGroupLayout,
+                  .entryCount = 1,
+                  .entries = &(WGPUBindGroupEntry){
+                      .binding = 0,
+                      .buffer = context->uniformBuffer,
+                      .offset = 0,
+                      .size = 4 * sizeof(float)}});
+
+  WriteViewportUniform(context);
+
+  context->rectInstanceCapacity = CLAY_WEBGPU_INITIAL_RECTANGLES;
+  context->rectInstances =
+      malloc(context->rectInstanceCapacity * sizeof(Clay_WebGPU_RectInstance));
+  context->drawRangeCapacity = CLAY_WEBGPU_INITIAL_DRAW_RANGES;
+  context->drawRanges =
+      malloc(context->drawRangeCapacity * sizeof(Clay_WebGPU_DrawRange));
+  if (!context->rectInstances || !context->drawRanges ||
+      !context->instanceRing.buffer) {
+    Clay_WebGPU_Cleanup(context);
+    return NULL;
+  }
 
   Log("Clay WebGPU渲染器初始化成功\n");
   return context;
@@ -178,7 +436,7 @@ bool Clay_WebGPU_LoadFont(Clay_WebGPU_Context *context, const char *fontPath,
   int fontId =
       text_renderer_load_font(context->textRenderer, fontPath, fontSize);
   if (fontId < 0) {
-    Log("字体加载失败: %s\n", fontPath);
+    LOG_ERROR("字体加载失败: %s\n", fontPath);
     return false;
   }
 
@@ -192,6 +450,19 @@ bool Clay_WebGPU_LoadFont(Clay_WebGPU_Context *context, const char *fontPath,
   return true;
 }
 
+bool Clay_WebGPU_LoadFallbackFont(Clay_WebGPU_Context *context,
+                                  const char *fontPath, int fontSize) {
+  if (!context || !context->textRenderer)
+    return false;
+
+  int fontId =
+      text_renderer_load_font(context->textRenderer, fontPath, fontSize);
+  if (fontId < 0)
+    return false;
+
+  return text_renderer_add_fallback_font(context->textRenderer, fontId);
+}
+
 bool Clay_WebGPU_SetDefaultFont(Clay_WebGPU_Context *context, int fontId) {
   if (!context || !context->textRenderer)
     return false;
@@ -204,6 +475,35 @@ bool Clay_WebGPU_SetDefaultFont(Clay_WebGPU_Context *context, int fontId) {
   return false;
 }
 
+void Clay_WebGPU_SetTextSdfMode(Clay_WebGPU_Context *context, bool enabled) {
+  if (!context || !context->textRenderer)
+    return;
+
+  text_renderer_set_sdf_mode(context->textRenderer, enabled);
+}
+
+void Clay_WebGPU_SetTextAsyncRaster(Clay_WebGPU_Context *context,
+                                    bool enabled) {
+  if (!context || !context->textRenderer)
+    return;
+
+  text_renderer_set_async_raster(context->textRenderer, enabled);
+}
+
+bool Clay_WebGPU_LoadTextCache(Clay_WebGPU_Context *context, const char *path) {
+  if (!context || !context->textRenderer)
+    return false;
+
+  return text_renderer_load_cache(context->textRenderer, path);
+}
+
+bool Clay_WebGPU_SaveTextCache(Clay_WebGPU_Context *context, const char *path) {
+  if (!context || !context->textRenderer)
+    return false;
+
+  return text_renderer_save_cache(context->textRenderer, path);
+}
+
 void Clay_WebGPU_UpdateScreenSize(Clay_WebGPU_Context *context,
                                   uint32_t screenWidth, uint32_t screenHeight) {
   if (!context)
@@ -211,6 +511,7 @@ void Clay_WebGPU_UpdateScreenSize(Clay_WebGPU_Context *context,
 
   context->screenWidth = screenWidth;
   context->screenHeight = screenHeight;
+  WriteViewportUniform(context);
 
   if (context->textRenderer) {
     text_renderer_update_screen_size(context->textRenderer, screenWidth,
@@ -236,12 +537,6 @@ void Clay_WebGPU_PrintTextStats(Clay_WebGPU_Context *context) {
   text_renderer_print_stats(context->textRenderer);
 }
 
-// 简单的矩形批处理结构
-typedef struct {
-  float vertices[6000 * 6]; // 最多1000个矩形，每个6顶点，6浮点数
-  int vertex_count;
-} RectangleBatch;
-
 void Clay_WebGPU_Render(Clay_WebGPU_Context *context,
                         Clay_RenderCommandArray renderCommands) {
   if (!context)
@@ -250,42 +545,32 @@ void Clay_WebGPU_Render(Clay_WebGPU_Context *context,
   static int frame_count = 0;
   frame_count++;
 
-  Log("=== 开始渲染帧 %d，总共 %d 个渲染命令 ===\n", frame_count,
-      renderCommands.length);
+  LOG_DEBUG("=== 开始渲染帧 %d，总共 %d 个渲染命令 ===\n", frame_count,
+            renderCommands.length);
 
-  WGPUCommandEncoderDescriptor encoderDesc = {
-      .label = {.data = "Clay Command Encoder", .length = WGPU_STRLEN}};
-  WGPUCommandEncoder encoder =
-      wgpuDeviceCreateCommandEncoder(context->device, &encoderDesc);
-
-  WGPURenderPassColorAttachment colorAttachment = {
-      .view = context->targetView,
-      .resolveTarget = NULL,
-      .clearValue = {0.1f, 0.1f, 0.1f, 1.0f}, // 深灰色背景
-      .loadOp = WGPULoadOp_Clear,
-      .storeOp = WGPUStoreOp_Store};
+  double translateStart = GetTimeMs();
 
-  WGPURenderPassDescriptor renderPassDesc = {
-      .label = {.data = "Clay Render Pass", .length = WGPU_STRLEN},
-      .colorAttachmentCount = 1,
-      .colorAttachments = &colorAttachment};
-
-  WGPURenderPassEncoder renderPass =
-      wgpuCommandEncoderBeginRenderPass(encoder, &renderPassDesc);
-
-  // 初始化矩形批处理
-  RectangleBatch rectangleBatch = {0};
+  // 重置矩形实例批处理和绘制列表
+  context->rectInstanceCount = 0;
+  context->drawRangeCount = 0;
+  gpu_ring_begin_frame(&context->instanceRing);
   int rectangle_count = 0;
+  int culled_count = 0;
 
   // 开始文本渲染帧
   text_renderer_begin_frame(context->textRenderer);
 
-  // 遍历所有渲染命令
+  // 重置裁剪栈
+  context->clipDepth = 0;
+  context->clipOverflow = 0;
+  UpdateScissor(context);
+
+  // 单次遍历所有渲染命令，按顺序生成绘制列表
   for (uint32_t i = 0; i < renderCommands.length; i++) {
     Clay_RenderCommand *renderCommand =
         Clay_RenderCommandArray_Get(&renderCommands, i);
 
-    Log("处理渲染命令 %d，类型: %d\n", i, renderCommand->commandType);
+    LOG_TRACE("处理渲染命令 %d，类型: %d\n", i, renderCommand->commandType);
 
     switch (renderCommand->commandType) {
     case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
@@ -294,129 +579,69 @@ void Clay_WebGPU_Render(Clay_WebGPU_Context *context,
           &renderCommand->renderData.rectangle;
       Clay_BoundingBox bbox = renderCommand->boundingBox;
 
-      Log("矩形 #%d: 原始颜色RGBA(%.0f,%.0f,%.0f,%.0f)\n", rectangle_count,
-          (float)rectangleData->backgroundColor.r,
-          (float)rectangleData->backgroundColor.g,
-          (float)rectangleData->backgroundColor.b,
-          (float)rectangleData->backgroundColor.a);
-
-      // 转换为NDC坐标
-      float x1 = (bbox.x / (float)context->screenWidth) * 2.0f - 1.0f;
-      float y1 = 1.0f - (bbox.y / (float)context->screenHeight) * 2.0f;
-      float x2 =
-          ((bbox.x + bbox.width) / (float)context->screenWidth) * 2.0f - 1.0f;
-      float y2 =
-          1.0f - ((bbox.y + bbox.height) / (float)context->screenHeight) * 2.0f;
-
-      float r = rectangleData->backgroundColor.r / 255.0f;
-      float g = rectangleData->backgroundColor.g / 255.0f;
-      float b = rectangleData->backgroundColor.b / 255.0f;
-      float a = rectangleData->backgroundColor.a / 255.0f;
+      LOG_TRACE("矩形 #%d: 原始颜色RGBA(%.0f,%.0f,%.0f,%.0f)\n", rectangle_count,
+                (float)rectangleData->backgroundColor.r,
+                (float)rectangleData->backgroundColor.g,
+                (float)rectangleData->backgroundColor.b,
+                (float)rectangleData->backgroundColor.a);
 
       // 检查是否有无效的坐标或颜色
       if (bbox.width <= 0 || bbox.height <= 0) {
-        Log("警告：矩形 #%d 尺寸无效 (%.1fx%.1f)，跳过渲染\n", rectangle_count,
-            bbox.width, bbox.height);
+        LOG_TRACE("警告：矩形 #%d 尺寸无效 (%.1fx%.1f)，跳过渲染\n", rectangle_count,
+                  bbox.width, bbox.height);
+        break;
+      }
+
+      if (rectangleData->backgroundColor.a <= 0.0f) {
+        LOG_TRACE("警告：矩形 #%d 透明度为0，跳过渲染\n", rectangle_count);
         break;
       }
 
-      if (a <= 0.0f) {
-        Log("警告：矩形 #%d 透明度为0，跳过渲染\n", rectangle_count);
+      // 完全位于裁剪区域之外，不写入实例缓冲区
+      if (IsOutsideClip(bbox, CurrentClip(context))) {
+        culled_count++;
         break;
       }
 
-      // 检查批处理是否还有空间（每个矩形6个顶点，每个顶点6个float）
-      if (rectangleBatch.vertex_count + 36 > 6000) {
-        Log("警告：矩形批处理已满，跳过剩余矩形\n");
+      if (!PushRectInstance(context, bbox, rectangleData->backgroundColor,
+                            rectangleData->cornerRadius)) {
+        LOG_ERROR("警告：矩形实例内存分配失败，跳过矩形\n");
         break;
       }
+      AppendDrawRange(context, CLAY_WEBGPU_DRAW_RECTANGLES,
+                      context->rectInstanceCount - 1, 1);
 
-      // 添加顶点数据到批处理：位置 + 颜色 (每个顶点6个float)
-      float *vertices = &rectangleBatch.vertices[rectangleBatch.vertex_count];
-
-      // 三角形1 (左上, 右上, 左下)
-      vertices[0] = x1;
-      vertices[1] = y1;
-      vertices[2] = r;
-      vertices[3] = g;
-      vertices[4] = b;
-      vertices[5] = a;
-      vertices[6] = x2;
-      vertices[7] = y1;
-      vertices[8] = r;
-      vertices[9] = g;
-      vertices[10] = b;
-      vertices[11] = a;
-      vertices[12] = x1;
-      vertices[13] = y2;
-      vertices[14] = r;
-      vertices[15] = g;
-      vertices[16] = b;
-      vertices[17] = a;
-
-      // 三角形2 (右上, 右下, 左下)
-      vertices[18] = x2;
-      vertices[19] = y1;
-      vertices[20] = r;
-      vertices[21] = g;
-      vertices[22] = b;
-      vertices[23] = a;
-      vertices[24] = x2;
-      vertices[25] = y2;
-      vertices[26] = r;
-      vertices[27] = g;
-      vertices[28] = b;
-      vertices[29] = a;
-      vertices[30] = x1;
-      vertices[31] = y2;
-      vertices[32] = r;
-      vertices[33] = g;
-      vertices[34] = b;
-      vertices[35] = a;
-
-      rectangleBatch.vertex_count += 36;
-
-      Log("+ 矩形 #%d 已添加到批处理: 位置(%.1f,%.1f) 尺寸(%.1fx%.1f) "
-          "NDC(%.3f,%.3f-%.3f,%.3f) 颜色(%.2f,%.2f,%.2f,%.2f)\n",
-          rectangle_count, bbox.x, bbox.y, bbox.width, bbox.height, x1, y1, x2,
-          y2, r, g, b, a);
+      LOG_TRACE("+ 矩形 #%d 已添加到批处理: 位置(%.1f,%.1f) 尺寸(%.1fx%.1f)\n",
+                rectangle_count, bbox.x, bbox.y, bbox.width, bbox.height);
       break;
     }
 
     case CLAY_RENDER_COMMAND_TYPE_BORDER: {
-      // 边框渲染（简化实现，渲染为4个矩形）
+      // 边框作为一个实例渲染，片段着色器用SDF减去内部圆角区域
       Clay_BorderRenderData *borderData = &renderCommand->renderData.border;
       Clay_BoundingBox bbox = renderCommand->boundingBox;
 
-      float r = borderData->color.r / 255.0f;
-      float g = borderData->color.g / 255.0f;
-      float b = borderData->color.b / 255.0f;
-      float a = borderData->color.a / 255.0f;
-
-      // 上边框
-      if (borderData->width.top > 0) {
-        float x1 = (bbox.x / (float)context->screenWidth) * 2.0f - 1.0f;
-        float y1 = 1.0f - (bbox.y / (float)context->screenHeight) * 2.0f;
-        float x2 =
-            ((bbox.x + bbox.width) / (float)context->screenWidth) * 2.0f - 1.0f;
-        float y2 = 1.0f - ((bbox.y + borderData->width.top) /
-                           (float)context->screenHeight) *
-                              2.0f;
-
-        float vertices[] = {x1, y1, r, g, b, a, x2, y1, r, g, b, a,
-                            x1, y2, r, g, b, a, x2, y1, r, g, b, a,
-                            x2, y2, r, g, b, a, x1, y2, r, g, b, a};
-
-        wgpuQueueWriteBuffer(context->queue, context->vertexBuffer, 0, vertices,
-                             sizeof(vertices));
-        wgpuRenderPassEncoderSetPipeline(renderPass,
-                                         context->rectanglePipeline);
-        wgpuRenderPassEncoderSetVertexBuffer(
-            renderPass, 0, context->vertexBuffer, 0, sizeof(vertices));
-        wgpuRenderPassEncoderDraw(renderPass, 6, 1, 0, 0);
+      if (bbox.width <= 0 || bbox.height <= 0 || borderData->color.a <= 0.0f)
+        break;
+
+      if (IsOutsideClip(bbox, CurrentClip(context))) {
+        culled_count++;
+        break;
+      }
+
+      Clay_WebGPU_RectInstance *instance = PushRectInstance(
+          context, bbox, borderData->color, borderData->cornerRadius);
+      if (!instance) {
+        LOG_ERROR("警告：矩形实例内存分配失败，跳过边框\n");
+        break;
       }
 
-      // 可以继续实现其他边框...
+      instance->borderWidth[0] = PackUnorm8(borderData->width.left);
+      instance->borderWidth[1] = PackUnorm8(borderData->width.right);
+      instance->borderWidth[2] = PackUnorm8(borderData->width.top);
+      instance->borderWidth[3] = PackUnorm8(borderData->width.bottom);
+      AppendDrawRange(context, CLAY_WEBGPU_DRAW_RECTANGLES,
+                      context->rectInstanceCount - 1, 1);
       break;
     }
 
@@ -424,18 +649,32 @@ void Clay_WebGPU_Render(Clay_WebGPU_Context *context,
       Clay_TextRenderData *textData = &renderCommand->renderData.text;
       Clay_BoundingBox bbox = renderCommand->boundingBox;
 
-      // 累积文本到批次，不立即渲染
-      Clay_WebGPU_RenderText(context, renderPass, textData, bbox);
+      // 整条文本都在裁剪区域之外时直接跳过（逐字形裁剪在文本渲染器中）
+      if (IsOutsideClip(bbox, CurrentClip(context))) {
+        culled_count++;
+        break;
+      }
+
+      // 累积文本到批次，记录本条文本占用的实例区间
+      uint32_t firstGlyph =
+          (uint32_t)context->textRenderer->current_batch.char_count;
+      text_renderer_render_clay_text(context->textRenderer, NULL, textData,
+                                     bbox);
+      AppendDrawRange(context, CLAY_WEBGPU_DRAW_TEXT, firstGlyph,
+                      (uint32_t)context->textRenderer->current_batch
+                              .char_count -
+                          firstGlyph);
       break;
     }
 
     case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
-      // TODO: 实现裁剪区域开始
+      // 与外层裁剪区域求交后入栈，后续区间使用新的裁剪矩形
+      PushClip(context, renderCommand->boundingBox);
       break;
     }
 
     case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END: {
-      // TODO: 实现裁剪区域结束
+      PopClip(context);
       break;
     }
 
@@ -444,42 +683,88 @@ void Clay_WebGPU_Render(Clay_WebGPU_Context *context,
     }
   }
 
-  // 渲染所有收集的矩形（批处理渲染）
-  if (rectangleBatch.vertex_count > 0) {
-    Log("开始批处理渲染 %d 个矩形 (%d 个顶点)\n",
-        rectangleBatch.vertex_count / 36, rectangleBatch.vertex_count / 6);
-
-    wgpuQueueWriteBuffer(context->queue, context->vertexBuffer, 0,
-                         rectangleBatch.vertices,
-                         rectangleBatch.vertex_count * sizeof(float));
-    wgpuRenderPassEncoderSetPipeline(renderPass, context->rectanglePipeline);
-    wgpuRenderPassEncoderSetVertexBuffer(
-        renderPass, 0, context->vertexBuffer, 0,
-        rectangleBatch.vertex_count * sizeof(float));
-    wgpuRenderPassEncoderDraw(renderPass, rectangleBatch.vertex_count / 6, 1, 0,
-                              0);
-
-    Log("✓ 批处理渲染完成！\n");
-  }
+  double uploadStart = GetTimeMs();
 
-  // 刷新任何剩余的文本批次
-  Log("准备刷新文本批次...\n");
-  if (context->textRenderer &&
-      context->textRenderer->current_batch.char_count > 0) {
-    Log("检测到 %d 个字符在文本批次中，准备渲染...\n",
-        context->textRenderer->current_batch.char_count);
-    text_renderer_flush_batch(context->textRenderer, renderPass);
-  } else {
-    Log("文本批次为空，无需渲染\n");
-  }
+  // 整帧数据各上传一次
+  GpuRingAllocation instanceAllocation = {0};
+  bool rectanglesReady =
+      context->rectInstanceCount > 0 &&
+      gpu_ring_upload(&context->instanceRing, context->rectInstances,
+                      context->rectInstanceCount *
+                          sizeof(Clay_WebGPU_RectInstance),
+                      &instanceAllocation);
+  bool textReady = text_renderer_upload_batch(context->textRenderer);
 
-  // 结束文本渲染帧
-  text_renderer_end_frame(context->textRenderer);
+  double submitStart = GetTimeMs();
+
+  WGPUCommandEncoderDescriptor encoderDesc = {
+      .label = {.data = "Clay Command Encoder", .length = WGPU_STRLEN}};
+  WGPUCommandEncoder encoder =
+      wgpuDeviceCreateCommandEncoder(context->device, &encoderDesc);
+
+  WGPURenderPassColorAttachment colorAttachment = {
+      .view = context->targetView,
+      .resolveTarget = NULL,
+      .clearValue = {0.1f, 0.1f, 0.1f, 1.0f}, // 深灰色背景
+      .loadOp = WGPULoadOp_Clear,
+      .storeOp = WGPUStoreOp_Store};
+
+  WGPURenderPassDescriptor renderPassDesc = {
+      .label = {.data = "Clay Render Pass", .length = WGPU_STRLEN},
+      .colorAttachmentCount = 1,
+      .colorAttachments = &colorAttachment};
+
+  WGPURenderPassEncoder renderPass =
+      wgpuCommandEncoderBeginRenderPass(encoder, &renderPassDesc);
+
+  // 按顺序回放绘制列表，只在图元类型或裁剪变化时切换状态
+  Clay_WebGPU_DrawType boundType = CLAY_WEBGPU_DRAW_RECTANGLES;
+  bool anyBound = false;
+  Clay_WebGPU_ScissorRect boundScissor = {0, 0, context->screenWidth,
+                                          context->screenHeight};
+  for (uint32_t i = 0; i < context->drawRangeCount; i++) {
+    Clay_WebGPU_DrawRange *range = &context->drawRanges[i];
+
+    if (!ScissorEquals(range->scissor, boundScissor)) {
+      wgpuRenderPassEncoderSetScissorRect(renderPass, range->scissor.x,
+                                          range->scissor.y,
+                                          range->scissor.width,
+                                          range->scissor.height);
+      boundScissor = range->scissor;
+    }
+
+    if (range->type == CLAY_WEBGPU_DRAW_RECTANGLES) {
+      if (!rectanglesReady)
+        continue;
+      if (!anyBound || boundType != range->type) {
+        wgpuRenderPassEncoderSetPipeline(renderPass,
+                                         context->rectanglePipeline);
+        wgpuRenderPassEncoderSetBindGroup(renderPass, 0,
+                                          context->rectangleBindGroup, 0, NULL);
+        wgpuRenderPassEncoderSetVertexBuffer(
+            renderPass, 0, instanceAllocation.buffer, instanceAllocation.offset,
+            instanceAllocation.size);
+      }
+      wgpuRenderPassEncoderDraw(renderPass, 6, range->count, 0, range->first);
+    } else {
+      if (!textReady)
+        continue;
+      if (!anyBound || boundType != range->type) {
+        text_renderer_bind_batch(context->textRenderer, renderPass);
+      }
+      text_renderer_draw_range(context->textRenderer, renderPass, range->first,
+                               range->count);
+    }
+
+    boundType = range->type;
+    anyBound = true;
+  }
 
   wgpuRenderPassEncoderEnd(renderPass);
 
-  Log("=== 渲染帧 %d 完成，共渲染 %d 个矩形 ===\n", frame_count,
-      rectangle_count);
+  LOG_DEBUG("=== 渲染帧 %d 完成，%u 个矩形实例，%u 次绘制，裁剪剔除 %d 个命令 ===\n",
+            frame_count, context->rectInstanceCount, context->drawRangeCount,
+            culled_count);
 
   WGPUCommandBufferDescriptor commandBufferDesc = {
       .label = {.data = "Clay Command Buffer", .length = WGPU_STRLEN}};
@@ -488,12 +773,162 @@ void Clay_WebGPU_Render(Clay_WebGPU_Context *context,
 
   wgpuQueueSubmit(context->queue, 1, &commandBuffer);
 
+  // 提交之后结束帧，环形缓冲区据此跟踪在途帧
+  gpu_ring_end_frame(&context->instanceRing);
+  text_renderer_end_frame(context->textRenderer);
+
+  double submitEnd = GetTimeMs();
+  context->lastFrameTimings = (Clay_WebGPU_FrameTimings){
+      .translateMs = uploadStart - translateStart,
+      .uploadMs = submitStart - uploadStart,
+      .submitMs = submitEnd - submitStart,
+      .drawCount = context->drawRangeCount,
+      .rectInstanceCount = context->rectInstanceCount,
+      .textCharCount =
+          context->textRenderer
+              ? (uint32_t)context->textRenderer->current_batch.char_count
+              : 0};
+
   // 清理资源
   wgpuCommandBufferRelease(commandBuffer);
   wgpuRenderPassEncoderRelease(renderPass);
   wgpuCommandEncoderRelease(encoder);
 }
 
+static void ReleaseOffscreenTarget(Clay_WebGPU_Context *context) {
+  if (context->readbackBuffer)
+    wgpuBufferRelease(context->readbackBuffer);
+  if (context->offscreenView)
+    wgpuTextureViewRelease(context->offscreenView);
+  if (context->offscreenTexture)
+    wgpuTextureRelease(context->offscreenTexture);
+
+  if (context->targetView == context->offscreenView)
+    context->targetView = NULL;
+  context->readbackBuffer = NULL;
+  context->offscreenView = NULL;
+  context->offscreenTexture = NULL;
+}
+
+bool Clay_WebGPU_CreateOffscreenTarget(Clay_WebGPU_Context *context,
+                                       uint32_t width, uint32_t height) {
+  if (!context || width == 0 || height == 0)
+    return false;
+
+  ReleaseOffscreenTarget(context);
+
+  context->offscreenTexture = wgpuDeviceCreateTexture(
+      context->device,
+      &(WGPUTextureDescriptor){
+          .label = {.data = "Clay Offscreen Target", .length = WGPU_STRLEN},
+          .usage =
+              WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc,
+          .dimension = WGPUTextureDimension_2D,
+          .size = {width, height, 1},
+          .format = WGPUTextureFormat_BGRA8Unorm,
+          .mipLevelCount = 1,
+          .sampleCount = 1});
+  if (!context->offscreenTexture) {
+    LOG_ERROR("离屏纹理创建失败\n");
+    return false;
+  }
+
+  context->offscreenView =
+      wgpuTextureCreateView(context->offscreenTexture, NULL);
+
+  // 纹理到缓冲区的拷贝要求每行字节数按256对齐
+  context->readbackBytesPerRow = (width * 4 + 255) & ~255u;
+  context->readbackBuffer = wgpuDeviceCreateBuffer(
+      context->device,
+      &(WGPUBufferDescriptor){
+          .label = {.data = "Clay Readback Buffer", .length = WGPU_STRLEN},
+          .usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst,
+          .size = (uint64_t)context->readbackBytesPerRow * height,
+          .mappedAtCreation = false});
+
+  if (!context->offscreenView || !context->readbackBuffer) {
+    ReleaseOffscreenTarget(context);
+    return false;
+  }
+
+  context->targetView = context->offscreenView;
+  Clay_WebGPU_UpdateScreenSize(context, width, height);
+
+  Log("离屏渲染目标创建成功 (%ux%u)\n", width, height);
+  return true;
+}
+
+static void OnReadbackMapped(WGPUMapAsyncStatus status, WGPUStringView message,
+                             void *userdata1, void *userdata2) {
+  (void)message;
+  (void)userdata2;
+  *(int *)userdata1 = (status == WGPUMapAsyncStatus_Success) ? 1 : -1;
+}
+
+bool Clay_WebGPU_ReadPixels(Clay_WebGPU_Context *context, uint8_t *pixels) {
+  if (!context || !context->offscreenTexture || !pixels)
+    return false;
+
+  uint32_t width = context->screenWidth;
+  uint32_t height = context->screenHeight;
+  uint64_t bufferSize = (uint64_t)context->readbackBytesPerRow * height;
+
+  WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(
+      context->device,
+      &(WGPUCommandEncoderDescriptor){
+          .label = {.data = "Clay Readback Encoder", .length = WGPU_STRLEN}});
+
+  wgpuCommandEncoderCopyTextureToBuffer(
+      encoder,
+      &(WGPUTexelCopyTextureInfo){.texture = context->offscreenTexture,
+                                  .mipLevel = 0,
+                                  .origin = {0, 0, 0},
+                                  .aspect = WGPUTextureAspect_All},
+      &(WGPUTexelCopyBufferInfo){
+          .layout = {.offset = 0,
+                     .bytesPerRow = context->readbackBytesPerRow,
+                     .rowsPerImage = height},
+          .buffer = context->readbackBuffer},
+      &(WGPUExtent3D){width, height, 1});
+
+  WGPUCommandBuffer commandBuffer = wgpuCommandEncoderFinish(
+      encoder,
+      &(WGPUCommandBufferDescriptor){
+          .label = {.data = "Clay Readback Commands", .length = WGPU_STRLEN}});
+  wgpuQueueSubmit(context->queue, 1, &commandBuffer);
+  wgpuCommandBufferRelease(commandBuffer);
+  wgpuCommandEncoderRelease(encoder);
+
+  // 映射回读缓冲区并阻塞等待
+  int mapState = 0;
+  wgpuBufferMapAsync(context->readbackBuffer, WGPUMapMode_Read, 0,
+                     (size_t)bufferSize,
+                     (WGPUBufferMapCallbackInfo){
+                         .mode = WGPUCallbackMode_AllowSpontaneous,
+                         .callback = OnReadbackMapped,
+                         .userdata1 = &mapState});
+  while (mapState == 0) {
+    wgpuDevicePoll(context->device, true, NULL);
+  }
+
+  if (mapState < 0) {
+    LOG_ERROR("回读缓冲区映射失败\n");
+    return false;
+  }
+
+  const uint8_t *mapped = wgpuBufferGetConstMappedRange(
+      context->readbackBuffer, 0, (size_t)bufferSize);
+  if (mapped) {
+    for (uint32_t y = 0; y < height; y++) {
+      memcpy(pixels + (size_t)y * width * 4,
+             mapped + (size_t)y * context->readbackBytesPerRow, width * 4);
+    }
+  }
+  wgpuBufferUnmap(context->readbackBuffer);
+
+  return mapped != NULL;
+}
+
 void Clay_WebGPU_Cleanup(Clay_WebGPU_Context *context) {
   if (!context)
     return;
@@ -501,17 +936,23 @@ void Clay_WebGPU_Cleanup(Clay_WebGPU_Context *context) {
   // 清理文本渲染器
   text_renderer_destroy(context->textRenderer);
 
+  // 清理离屏目标
+  ReleaseOffscreenTarget(context);
+
   // 清理缓冲区
-  if (context->vertexBuffer)
-    wgpuBufferRelease(context->vertexBuffer);
-  if (context->indexBuffer)
-    wgpuBufferRelease(context->indexBuffer);
+  free(context->rectInstances);
+  free(context->drawRanges);
+  if (context->rectangleBindGroup)
+    wgpuBindGroupRelease(context->rectangleBindGroup);
+  gpu_ring_destroy(&context->instanceRing);
   if (context->uniformBuffer)
     wgpuBufferRelease(context->uniformBuffer);
 
   // 清理渲染管线
   if (context->rectanglePipeline)
     wgpuRenderPipelineRelease(context->rectanglePipeline);
+  if (context->rectangleBindGroupLayout)
+    wgpuBindGroupLayoutRelease(context->rectangleBindGroupLayout);
 
   free(context);
   Log("Clay WebGPU渲染器已清理\n");
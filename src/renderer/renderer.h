@@ -2,6 +2,7 @@
 #define CLAY_RENDERER_WEBGPU_H
 
 #include "clay.h"
+#include "gpu_ring_buffer.h"
 #include "text_renderer.h"
 #include <webgpu/wgpu.h>
 
@@ -10,19 +11,90 @@
 #define CLAY_FONT_ATLAS_WIDTH 1024
 #define CLAY_FONT_ATLAS_HEIGHT 1024
 
+// 矩形实例CPU数组的初始容量（按需翻倍增长）
+#define CLAY_WEBGPU_INITIAL_RECTANGLES 1024
+// 矩形实例环形缓冲区的初始大小
+#define CLAY_WEBGPU_RECT_RING_SIZE (1024 * 1024)
+// 绘制列表的初始容量
+#define CLAY_WEBGPU_INITIAL_DRAW_RANGES 64
+// 裁剪栈最大嵌套深度
+#define CLAY_WEBGPU_MAX_CLIP_DEPTH 32
 
+// 矩形实例数据 - 每个矩形/边框只上传一条记录，四边形由顶点着色器根据
+// vertex_index 展开（28字节，旧方案为6顶点×6浮点数=144字节）
+typedef struct {
+  float x, y, width, height; // 像素坐标包围盒
+  uint8_t color[4];          // RGBA8
+  uint8_t cornerRadius[4];   // 左上、右上、右下、左下圆角半径（像素）
+  uint8_t borderWidth[4];    // 左、右、上、下边框宽度（像素），全0表示填充
+} Clay_WebGPU_RectInstance;
+
+// 绘制列表：按Clay命令顺序记录的绘制区间，相邻的同类图元合并为一次绘制
+typedef enum {
+  CLAY_WEBGPU_DRAW_RECTANGLES, // first/count 为矩形实例区间
+  CLAY_WEBGPU_DRAW_TEXT,       // first/count 为文本批次的字形实例区间
+} Clay_WebGPU_DrawType;
+
+// 裁剪矩形（渲染目标像素坐标）
+typedef struct {
+  uint32_t x, y, width, height;
+} Clay_WebGPU_ScissorRect;
+
+typedef struct {
+  Clay_WebGPU_DrawType type;
+  uint32_t first;
+  uint32_t count;
+  Clay_WebGPU_ScissorRect scissor; // 裁剪不同的区间不会合并
+} Clay_WebGPU_DrawRange;
+
+// 单帧各阶段耗时（毫秒）与计数，供基准测试读取
+typedef struct {
+  double translateMs; // 遍历渲染命令，生成实例与字形四边形（含字形生成）
+  double uploadMs;    // 图集、实例与文本顶点数据上传
+  double submitMs;    // 编码绘制列表并提交队列
+  uint32_t drawCount;
+  uint32_t rectInstanceCount;
+  uint32_t textCharCount;
+} Clay_WebGPU_FrameTimings;
 
 typedef struct {
   WGPUDevice device;
   WGPUQueue queue;
   WGPURenderPipeline rectanglePipeline;
-  WGPUBuffer vertexBuffer;
-  WGPUBuffer indexBuffer;
+  WGPUBindGroupLayout rectangleBindGroupLayout;
+  WGPUBindGroup rectangleBindGroup;
+  GpuRingBuffer instanceRing; // 矩形实例环形缓冲区
   WGPUBuffer uniformBuffer;
   WGPUTextureView targetView;
+
+  // 离屏渲染目标（无窗口模式），创建后 targetView 指向它
+  WGPUTexture offscreenTexture;
+  WGPUTextureView offscreenView;
+  WGPUBuffer readbackBuffer;
+  uint32_t readbackBytesPerRow;
+
   uint32_t screenWidth;
   uint32_t screenHeight;
 
+  // 当前帧的矩形实例（CPU端）
+  Clay_WebGPU_RectInstance *rectInstances;
+  uint32_t rectInstanceCount;
+  uint32_t rectInstanceCapacity;
+
+  // 当前帧的有序绘制列表
+  Clay_WebGPU_DrawRange *drawRanges;
+  uint32_t drawRangeCount;
+  uint32_t drawRangeCapacity;
+
+  // 上一帧的分阶段计时
+  Clay_WebGPU_FrameTimings lastFrameTimings;
+
+  // 裁剪栈（SCISSOR_START/END），栈顶为与所有外层求交后的区域
+  Clay_BoundingBox clipStack[CLAY_WEBGPU_MAX_CLIP_DEPTH];
+  uint32_t clipDepth;
+  uint32_t clipOverflow; // 栈满后多出的压栈次数，出栈时先抵消
+  Clay_WebGPU_ScissorRect currentScissor;
+
   // 新的独立文本渲染器
   TextRenderer *textRenderer;
   
@@ -40,10 +112,26 @@ void Clay_WebGPU_Render(Clay_WebGPU_Context *context,
                         Clay_RenderCommandArray renderCommands);
 void Clay_WebGPU_Cleanup(Clay_WebGPU_Context *context);
 
+// 离屏渲染（无窗口/CI）：创建BGRA8离屏纹理作为渲染目标，并可回读到CPU
+bool Clay_WebGPU_CreateOffscreenTarget(Clay_WebGPU_Context *context,
+                                       uint32_t width, uint32_t height);
+// 将离屏目标的最后一帧读回 pixels（width*height*4 字节，BGRA顺序），阻塞直到完成
+bool Clay_WebGPU_ReadPixels(Clay_WebGPU_Context *context, uint8_t *pixels);
+
 // 字体管理函数
 bool Clay_WebGPU_LoadFont(Clay_WebGPU_Context *context, const char *fontPath,
                           int fontSize);
 bool Clay_WebGPU_SetDefaultFont(Clay_WebGPU_Context *context, int fontId);
+// 加载字体并加入回退链，用于补全默认字体缺失的字符
+bool Clay_WebGPU_LoadFallbackFont(Clay_WebGPU_Context *context,
+                                  const char *fontPath, int fontSize);
+// 开启后每个字符只生成一份距离场，所有字号共用
+void Clay_WebGPU_SetTextSdfMode(Clay_WebGPU_Context *context, bool enabled);
+// 后台光栅化（默认开启）：新字形先占位，下一帧显示，避免首次出现时卡帧
+void Clay_WebGPU_SetTextAsyncRaster(Clay_WebGPU_Context *context, bool enabled);
+// 持久化字形缓存：字体加载之后、第一帧之前加载，退出前保存
+bool Clay_WebGPU_LoadTextCache(Clay_WebGPU_Context *context, const char *path);
+bool Clay_WebGPU_SaveTextCache(Clay_WebGPU_Context *context, const char *path);
 
 // 文本渲染函数 (使用新的文本渲染器)
 void Clay_WebGPU_RenderText(Clay_WebGPU_Context *context, WGPURenderPassEncoder renderPass,
@@ -1,18 +1,40 @@
 // text_renderer.c - 独立的文本渲染系统实现
 #include "text_renderer.h"
 #include "../DEV.h"
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "stb_truetype.h"
 
 // WebGPU着色器代码
+// 每个字形一个实例：尺寸、偏移与纹理坐标从GPU字形表读取，
+// 表中度量以栅格化字号归一化，乘以实例的请求字号得到像素尺寸；
+// 字形所在的图集页（纹理数组层）同样记录在表中，所有页共用一次绘制
 static const char *text_vertex_shader_wgsl =
-    "struct VertexInput {\n"
-    "    @location(0) position: vec2<f32>,\n"
-    "    @location(1) texCoords: vec2<f32>,\n"
+    "struct Glyph {\n"
+    "    uv: vec4<f32>,\n"
+    "    rect: vec4<f32>,\n"
+    "    layer: u32,\n"
+    "}\n"
+    "\n"
+    "struct Screen {\n"
+    "    size: vec2<f32>,\n"
+    "    _pad: vec2<f32>,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(2) var<storage, read> glyphs: array<Glyph>;\n"
+    "@group(0) @binding(3) var<uniform> screen: Screen;\n"
+    "\n"
+    "struct InstanceInput {\n"
+    "    @location(0) pen: vec2<f32>,\n"
+    "    @location(1) glyph: u32,\n"
     "    @location(2) color: vec4<f32>,\n"
     "}\n"
     "\n"
@@ -20,14 +42,26 @@ static const char *text_vertex_shader_wgsl =
     "    @builtin(position) position: vec4<f32>,\n"
     "    @location(0) texCoords: vec2<f32>,\n"
     "    @location(1) color: vec4<f32>,\n"
+    "    @location(2) @interpolate(flat) layer: u32,\n"
     "}\n"
     "\n"
     "@vertex\n"
-    "fn vs_main(input: VertexInput) -> VertexOutput {\n"
+    "fn vs_main(@builtin(vertex_index) vertexIndex: u32,\n"
+    "           input: InstanceInput) -> VertexOutput {\n"
+    "    // 三角形 (左上, 右上, 左下) (右上, 右下, 左下) 的角点位掩码\n"
+    "    let corner = vec2<f32>(f32((0x1Au >> vertexIndex) & 1u),\n"
+    "                           f32((0x34u >> vertexIndex) & 1u));\n"
+    "    let glyph = glyphs[input.glyph & 0xFFFFu];\n"
+    "    let fontSize = f32(input.glyph >> 16u);\n"
+    "    let pixel = input.pen + (glyph.rect.xy + corner * glyph.rect.zw) * "
+    "fontSize;\n"
     "    var output: VertexOutput;\n"
-    "    output.position = vec4<f32>(input.position, 0.0, 1.0);\n"
-    "    output.texCoords = input.texCoords;\n"
+    "    output.position = vec4<f32>(pixel.x / screen.size.x * 2.0 - 1.0,\n"
+    "                                1.0 - pixel.y / screen.size.y * 2.0, 0.0, "
+    "1.0);\n"
+    "    output.texCoords = mix(glyph.uv.xy, glyph.uv.zw, corner);\n"
     "    output.color = input.color;\n"
+    "    output.layer = glyph.layer;\n"
     "    return output;\n"
     "}\n";
 
@@ -35,15 +69,37 @@ static const char *text_fragment_shader_wgsl =
     "struct FragmentInput {\n"
     "    @location(0) texCoords: vec2<f32>,\n"
     "    @location(1) color: vec4<f32>,\n"
+    "    @location(2) @interpolate(flat) layer: u32,\n"
     "}\n"
     "\n"
-    "@group(0) @binding(0) var textTexture: texture_2d<f32>;\n"
+    "@group(0) @binding(0) var textTexture: texture_2d_array<f32>;\n"
     "@group(0) @binding(1) var textSampler: sampler;\n"
     "\n"
     "@fragment\n"
     "fn fs_main(input: FragmentInput) -> @location(0) vec4<f32> {\n"
     "    let alpha = textureSample(textTexture, textSampler, "
-    "input.texCoords).r;\n"
+    "input.texCoords, input.layer).r;\n"
+    "    return vec4<f32>(input.color.rgb, input.color.a * alpha);\n"
+    "}\n";
+
+// SDF模式的片段着色器：0.5 为字形边缘，抗锯齿宽度取屏幕空间导数，
+// 因此同一份距离场在任意缩放下都保持一像素左右的过渡
+static const char *text_sdf_fragment_shader_wgsl =
+    "struct FragmentInput {\n"
+    "    @location(0) texCoords: vec2<f32>,\n"
+    "    @location(1) color: vec4<f32>,\n"
+    "    @location(2) @interpolate(flat) layer: u32,\n"
+    "}\n"
+    "\n"
+    "@group(0) @binding(0) var textTexture: texture_2d_array<f32>;\n"
+    "@group(0) @binding(1) var textSampler: sampler;\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(input: FragmentInput) -> @location(0) vec4<f32> {\n"
+    "    let distance = textureSample(textTexture, textSampler, "
+    "input.texCoords, input.layer).r;\n"
+    "    let smoothing = max(fwidth(distance) * 0.5, 0.001);\n"
+    "    let alpha = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);\n"
     "    return vec4<f32>(input.color.rgb, input.color.a * alpha);\n"
     "}\n";
 
@@ -103,87 +159,178 @@ UTF8Result text_decode_utf8(const char **utf8_str) {
 }
 
 int text_utf8_string_length(const char *utf8_str, int byte_length) {
+  uint32_t codepoints[TEXT_DECODE_CHUNK];
   int char_count = 0;
-  const char *ptr = utf8_str;
-  const char *end = utf8_str + byte_length;
-
-  while (ptr < end && *ptr != 0) {
-    UTF8Result result = text_decode_utf8(&ptr);
-    if (!result.valid)
-      break;
-    char_count++;
+  int pos = 0;
+
+  while (pos < byte_length) {
+    int consumed;
+    int count = utf8_decode_run(utf8_str + pos, byte_length - pos, codepoints,
+                                TEXT_DECODE_CHUNK, &consumed);
+    char_count += count;
+    pos += consumed;
+    if (count < TEXT_DECODE_CHUNK)
+      break; // 到达末尾或遇到NUL
   }
 
   return char_count;
 }
 
-// 哈希函数，用于字形缓存
-static uint32_t hash_glyph_key(uint32_t codepoint, int font_id) {
-  uint32_t key = (codepoint << 8) | (font_id & 0xFF);
-  key = ((key >> 16) ^ key) * 0x45d9f3b;
-  key = ((key >> 16) ^ key) * 0x45d9f3b;
-  key = (key >> 16) ^ key;
-  return key % TEXT_GLYPH_CACHE_SIZE;
+// 在缓存中查找字形，不更新统计与LRU信息
+static TextGlyphCacheEntry *lookup_glyph_cache_entry(TextRenderer *renderer,
+                                                     uint32_t glyph_index,
+                                                     int font_id,
+                                                     int pixel_size) {
+  int slot =
+      glyph_table_find(&renderer->glyph_lookup,
+                       glyph_table_key(glyph_index, font_id, pixel_size));
+  return slot >= 0 ? &renderer->glyph_cache[slot] : NULL;
 }
 
 // 在缓存中查找字形
 static TextGlyphCacheEntry *find_glyph_cache_entry(TextRenderer *renderer,
-                                                   uint32_t codepoint,
-                                                   int font_id) {
-  uint32_t index = hash_glyph_key(codepoint, font_id);
-  uint32_t original_index = index;
+                                                   uint32_t glyph_index,
+                                                   int font_id, int pixel_size) {
+  TextGlyphCacheEntry *entry =
+      lookup_glyph_cache_entry(renderer, glyph_index, font_id, pixel_size);
+  if (entry) {
+    renderer->cache_hits++;
+    entry->last_used_frame = renderer->frame_index;
+  }
+  return entry;
+}
 
-  do {
-    TextGlyphCacheEntry *entry = &renderer->glyph_cache[index];
+// 缓存条目槽位（同时是GPU字形表槽位）的空闲列表
+static void reset_gpu_slots(TextRenderer *renderer) {
+  for (int i = 0; i < TEXT_GLYPH_CACHE_SIZE; i++) {
+    renderer->gpu_free_slots[i] = (uint16_t)(TEXT_GLYPH_CACHE_SIZE - 1 - i);
+  }
+  renderer->gpu_free_count = TEXT_GLYPH_CACHE_SIZE;
+  renderer->gpu_retired_count = 0;
+  renderer->gpu_dirty_min = TEXT_GLYPH_CACHE_SIZE;
+  renderer->gpu_dirty_max = -1;
+}
 
-    if (!entry->occupied) {
-      return NULL; // 空槽位，字形不在缓存中
-    }
+// 删除的槽位到下一帧开始时才回到空闲列表
+static void retire_gpu_slot(TextRenderer *renderer, uint16_t slot) {
+  renderer->gpu_retired_slots[renderer->gpu_retired_count++] = slot;
+}
 
-    if (entry->codepoint == codepoint && entry->font_id == font_id) {
-      renderer->cache_hits++;
-      return entry; // 找到匹配的字形
-    }
+static void write_gpu_glyph(TextRenderer *renderer,
+                            const TextGlyphCacheEntry *entry) {
+  const TextGlyph *glyph = &entry->glyph;
+  int slot = glyph->gpu_slot;
+  float raster_size = entry->pixel_size == TEXT_SDF_SIZE_KEY
+                          ? (float)TEXT_SDF_BASE_SIZE
+                          : (float)entry->pixel_size;
+
+  // 字形顶部 = 基线 - bearing_y - height（与CPU端裁剪计算一致）
+  renderer->gpu_glyphs[slot] = (TextGpuGlyph){
+      .uv = {glyph->u0, glyph->v0, glyph->u1, glyph->v1},
+      .rect = {glyph->bearing_x / raster_size,
+               (-glyph->bearing_y - glyph->height) / raster_size,
+               glyph->width / raster_size, glyph->height / raster_size},
+      .layer = glyph->atlas_layer};
+
+  if (slot < renderer->gpu_dirty_min)
+    renderer->gpu_dirty_min = slot;
+  if (slot > renderer->gpu_dirty_max)
+    renderer->gpu_dirty_max = slot;
+}
 
-    index = (index + 1) % TEXT_GLYPH_CACHE_SIZE;
-  } while (index != original_index);
+static void fill_glyph_cache_entry(TextRenderer *renderer,
+                                   TextGlyphCacheEntry *entry,
+                                   uint32_t glyph_index, int font_id,
+                                   int pixel_size, const TextGlyph *glyph) {
+  entry->glyph_index = glyph_index;
+  entry->font_id = font_id;
+  entry->pixel_size = pixel_size;
+  entry->glyph = *glyph;
+  entry->occupied = true;
+  entry->atlas_shelf = -1;
+  entry->last_used_frame = renderer->frame_index;
+  entry->raster_job = 0;
+}
 
-  return NULL; // 缓存已满且未找到
+// 归还字形占用的图集区域
+static void free_atlas_rect(TextRenderer *renderer, int layer,
+                            AtlasPackerRect rect, int shelf) {
+  atlas_packer_free(&renderer->atlas.pages[layer]->packer, rect, shelf);
 }
 
-// 向缓存添加字形
-static void add_glyph_to_cache(TextRenderer *renderer, uint32_t codepoint,
-                               int font_id, const TextGlyph *glyph) {
-  uint32_t index = hash_glyph_key(codepoint, font_id);
-  uint32_t original_index = index;
+// 删除条目：从索引中移除键，槽位推迟到下一帧复用
+static void remove_glyph_cache_entry(TextRenderer *renderer, uint16_t slot) {
+  TextGlyphCacheEntry *entry = &renderer->glyph_cache[slot];
+  glyph_table_remove(&renderer->glyph_lookup,
+                     glyph_table_key(entry->glyph_index, entry->font_id,
+                                     entry->pixel_size));
+  retire_gpu_slot(renderer, slot);
+  entry->occupied = false;
+}
 
-  do {
-    TextGlyphCacheEntry *entry = &renderer->glyph_cache[index];
+// 淘汰至少 min_age 帧未使用的字形，原地归还其图集空间
+// 空白字符不占图集，但同样占用缓存槽位，一并淘汰
+static int evict_glyphs(TextRenderer *renderer, uint32_t min_age) {
+  int evicted = 0;
 
-    if (!entry->occupied) {
-      // 找到空槽位
-      entry->codepoint = codepoint;
-      entry->font_id = font_id;
-      entry->glyph = *glyph;
-      entry->occupied = true;
-      return;
-    }
+  for (int i = 0; i < TEXT_GLYPH_CACHE_SIZE; i++) {
+    TextGlyphCacheEntry *entry = &renderer->glyph_cache[i];
+    if (!entry->occupied ||
+        renderer->frame_index - entry->last_used_frame < min_age)
+      continue;
 
-    if (entry->codepoint == codepoint && entry->font_id == font_id) {
-      // 更新现有条目
-      entry->glyph = *glyph;
-      return;
-    }
+    if (entry->atlas_shelf >= 0)
+      free_atlas_rect(renderer, entry->glyph.atlas_layer, entry->atlas_rect,
+                      entry->atlas_shelf);
+    remove_glyph_cache_entry(renderer, (uint16_t)i);
+    evicted++;
+  }
 
-    index = (index + 1) % TEXT_GLYPH_CACHE_SIZE;
-  } while (index != original_index);
+  renderer->evicted_glyphs += evicted;
+  if (evicted > 0)
+    renderer->atlas_generation++; // 引用被淘汰字形的文本段需要重新排版
+  return evicted;
+}
 
-  // 缓存已满，覆盖原始位置（LRU策略可以在这里实现）
-  TextGlyphCacheEntry *entry = &renderer->glyph_cache[original_index];
-  entry->codepoint = codepoint;
-  entry->font_id = font_id;
-  entry->glyph = *glyph;
-  entry->occupied = true;
+// 向缓存添加字形，返回条目以便调用方记录图集区域
+static TextGlyphCacheEntry *add_glyph_to_cache(TextRenderer *renderer,
+                                               uint32_t glyph_index, int font_id,
+                                               int pixel_size,
+                                               const TextGlyph *glyph) {
+  uint64_t key = glyph_table_key(glyph_index, font_id, pixel_size);
+  int slot = glyph_table_find(&renderer->glyph_lookup, key);
+  if (slot >= 0) {
+    // 更新现有条目（沿用原槽位），归还旧的图集空间
+    TextGlyphCacheEntry *entry = &renderer->glyph_cache[slot];
+    if (entry->atlas_shelf >= 0)
+      free_atlas_rect(renderer, entry->glyph.atlas_layer, entry->atlas_rect,
+                      entry->atlas_shelf);
+    fill_glyph_cache_entry(renderer, entry, glyph_index, font_id, pixel_size,
+                           glyph);
+    entry->glyph.gpu_slot = (uint16_t)slot;
+    write_gpu_glyph(renderer, entry);
+    return entry;
+  }
+
+  if (renderer->gpu_free_count == 0) {
+    // 槽位用尽：淘汰长时间未用的字形，腾出的槽位从下一帧起可用
+    if (evict_glyphs(renderer, TEXT_ATLAS_EVICT_FRAMES) == 0)
+      evict_glyphs(renderer, 1);
+    return NULL;
+  }
+
+  slot = renderer->gpu_free_slots[--renderer->gpu_free_count];
+  if (!glyph_table_insert(&renderer->glyph_lookup, key, (uint16_t)slot)) {
+    renderer->gpu_free_slots[renderer->gpu_free_count++] = (uint16_t)slot;
+    return NULL;
+  }
+
+  TextGlyphCacheEntry *entry = &renderer->glyph_cache[slot];
+  fill_glyph_cache_entry(renderer, entry, glyph_index, font_id, pixel_size,
+                         glyph);
+  entry->glyph.gpu_slot = (uint16_t)slot;
+  write_gpu_glyph(renderer, entry);
+  return entry;
 }
 
 // 创建WebGPU渲染管线
@@ -213,19 +360,38 @@ static bool create_text_pipeline(TextRenderer *renderer) {
   WGPUShaderModule fragment_shader =
       wgpuDeviceCreateShaderModule(renderer->device, &fragment_shader_desc);
 
-  // 创建绑定组布局（移除uniform buffer）
+  WGPUShaderSourceWGSL sdf_fragment_shader_source = {
+      .chain = {.sType = WGPUSType_ShaderSourceWGSL},
+      .code = {.data = text_sdf_fragment_shader_wgsl, .length = WGPU_STRLEN}};
+
+  WGPUShaderModuleDescriptor sdf_fragment_shader_desc = {
+      .nextInChain = (const WGPUChainedStruct *)&sdf_fragment_shader_source,
+      .label = {.data = "Text SDF Fragment Shader", .length = WGPU_STRLEN}};
+
+  WGPUShaderModule sdf_fragment_shader =
+      wgpuDeviceCreateShaderModule(renderer->device, &sdf_fragment_shader_desc);
+
+  // 创建绑定组布局：图集纹理、采样器、GPU字形表、屏幕尺寸
   WGPUBindGroupLayoutEntry bind_group_entries[] = {
       {.binding = 0,
        .visibility = WGPUShaderStage_Fragment,
        .texture = {.sampleType = WGPUTextureSampleType_Float,
-                   .viewDimension = WGPUTextureViewDimension_2D,
+                   .viewDimension = WGPUTextureViewDimension_2DArray,
                    .multisampled = false}},
       {.binding = 1,
        .visibility = WGPUShaderStage_Fragment,
-       .sampler = {.type = WGPUSamplerBindingType_Filtering}}};
+       .sampler = {.type = WGPUSamplerBindingType_Filtering}},
+      {.binding = 2,
+       .visibility = WGPUShaderStage_Vertex,
+       .buffer = {.type = WGPUBufferBindingType_ReadOnlyStorage,
+                  .minBindingSize = sizeof(TextGpuGlyph)}},
+      {.binding = 3,
+       .visibility = WGPUShaderStage_Vertex,
+       .buffer = {.type = WGPUBufferBindingType_Uniform,
+                  .minBindingSize = 4 * sizeof(float)}}};
 
   WGPUBindGroupLayoutDescriptor bind_group_layout_desc = {
-      .entryCount = 2, .entries = bind_group_entries};
+      .entryCount = 4, .entries = bind_group_entries};
 
   text_bind_group_layout = wgpuDeviceCreateBindGroupLayout(
       renderer->device, &bind_group_layout_desc);
@@ -236,19 +402,21 @@ static bool create_text_pipeline(TextRenderer *renderer) {
   WGPUPipelineLayout pipeline_layout =
       wgpuDeviceCreatePipelineLayout(renderer->device, &pipeline_layout_desc);
 
-  // 顶点属性（包含颜色）
+  // 实例属性：笔位置、字形槽位与字号、颜色
   WGPUVertexAttribute vertex_attributes[] = {
-      {.format = WGPUVertexFormat_Float32x2, .offset = 0, .shaderLocation = 0},
       {.format = WGPUVertexFormat_Float32x2,
-       .offset = sizeof(float) * 2,
+       .offset = offsetof(TextGlyphInstance, pen_x),
+       .shaderLocation = 0},
+      {.format = WGPUVertexFormat_Uint32,
+       .offset = offsetof(TextGlyphInstance, glyph),
        .shaderLocation = 1},
-      {.format = WGPUVertexFormat_Float32x4,
-       .offset = sizeof(float) * 4,
+      {.format = WGPUVertexFormat_Unorm8x4,
+       .offset = offsetof(TextGlyphInstance, color),
        .shaderLocation = 2}};
 
   WGPUVertexBufferLayout vertex_buffer_layout = {
-      .arrayStride = sizeof(float) * 8,
-      .stepMode = WGPUVertexStepMode_Vertex,
+      .arrayStride = sizeof(TextGlyphInstance),
+      .stepMode = WGPUVertexStepMode_Instance,
       .attributeCount = 3,
       .attributes = vertex_attributes};
 
@@ -266,6 +434,12 @@ static bool create_text_pipeline(TextRenderer *renderer) {
       .blend = &blend_state,
       .writeMask = WGPUColorWriteMask_All};
 
+  WGPUFragmentState fragment_state = {
+      .module = fragment_shader,
+      .entryPoint = {.data = "fs_main", .length = WGPU_STRLEN},
+      .targetCount = 1,
+      .targets = &color_target_state};
+
   // 创建渲染管线
   WGPURenderPipelineDescriptor pipeline_desc = {
       .label = {.data = "Text Render Pipeline", .length = WGPU_STRLEN},
@@ -274,11 +448,7 @@ static bool create_text_pipeline(TextRenderer *renderer) {
                  .entryPoint = {.data = "vs_main", .length = WGPU_STRLEN},
                  .bufferCount = 1,
                  .buffers = &vertex_buffer_layout},
-      .fragment = &(WGPUFragmentState){.module = fragment_shader,
-                                       .entryPoint = {.data = "fs_main",
-                                                      .length = WGPU_STRLEN},
-                                       .targetCount = 1,
-                                       .targets = &color_target_state},
+      .fragment = &fragment_state,
       .primitive = {.topology = WGPUPrimitiveTopology_TriangleList,
                     .stripIndexFormat = WGPUIndexFormat_Undefined,
                     .frontFace = WGPUFrontFace_CCW,
@@ -289,58 +459,252 @@ static bool create_text_pipeline(TextRenderer *renderer) {
   renderer->text_pipeline =
       wgpuDeviceCreateRenderPipeline(renderer->device, &pipeline_desc);
 
+  // SDF管线只替换片段着色器，实例格式与绑定组相同
+  fragment_state.module = sdf_fragment_shader;
+  pipeline_desc.label =
+      (WGPUStringView){.data = "Text SDF Render Pipeline", .length = WGPU_STRLEN};
+  renderer->sdf_pipeline =
+      wgpuDeviceCreateRenderPipeline(renderer->device, &pipeline_desc);
+
   // 清理资源
   wgpuShaderModuleRelease(vertex_shader);
   wgpuShaderModuleRelease(fragment_shader);
+  wgpuShaderModuleRelease(sdf_fragment_shader);
   wgpuPipelineLayoutRelease(pipeline_layout);
 
-  return renderer->text_pipeline != NULL;
+  return renderer->text_pipeline != NULL && renderer->sdf_pipeline != NULL;
+}
+
+static void write_screen_uniform(TextRenderer *renderer) {
+  float screen[4] = {(float)renderer->screen_width,
+                     (float)renderer->screen_height, 0.0f, 0.0f};
+  wgpuQueueWriteBuffer(renderer->queue, renderer->screen_uniform_buffer, 0,
+                       screen, sizeof(screen));
 }
 
 // 创建缓冲区
 static bool create_buffers(TextRenderer *renderer) {
-  // 顶点缓冲区（更新大小以包含颜色数据）
-  renderer->vertex_buffer = wgpuDeviceCreateBuffer(
+  renderer->glyph_table_buffer = wgpuDeviceCreateBuffer(
       renderer->device,
       &(WGPUBufferDescriptor){
-          .label = {.data = "Text Vertex Buffer", .length = WGPU_STRLEN},
-          .usage = WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst,
-          .size = TEXT_MAX_CHARS_PER_BATCH * 4 * 8 * sizeof(float),
-          .mappedAtCreation = false});
-
-  // 索引缓冲区
-  renderer->index_buffer = wgpuDeviceCreateBuffer(
+          .label = {.data = "Text Glyph Table", .length = WGPU_STRLEN},
+          .usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+          .size = sizeof(renderer->gpu_glyphs)});
+  renderer->screen_uniform_buffer = wgpuDeviceCreateBuffer(
       renderer->device,
       &(WGPUBufferDescriptor){
-          .label = {.data = "Text Index Buffer", .length = WGPU_STRLEN},
-          .usage = WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst,
-          .size = TEXT_MAX_CHARS_PER_BATCH * 6 * sizeof(uint16_t),
-          .mappedAtCreation = false});
+          .label = {.data = "Text Screen Uniform", .length = WGPU_STRLEN},
+          .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+          .size = 4 * sizeof(float)});
+  if (!renderer->glyph_table_buffer || !renderer->screen_uniform_buffer)
+    return false;
+  write_screen_uniform(renderer);
 
-  return renderer->vertex_buffer && renderer->index_buffer;
+  // 字形实例使用环形缓冲区，每次上传批次时子分配
+  return gpu_ring_init(&renderer->geometry_ring, renderer->device,
+                       renderer->queue, WGPUBufferUsage_Vertex,
+                       TEXT_GEOMETRY_RING_SIZE, "Text Instance Ring");
 }
 
-// 创建纹理图集
-static bool create_atlas(TextRenderer *renderer) {
-  // 创建纹理
+// 封存当前段：实例上传到环形缓冲区，之后的实例从新段开始写入
+static bool seal_batch_segment(TextRenderer *renderer) {
+  TextRenderBatch *batch = &renderer->current_batch;
+  int count = batch->char_count - batch->segment_first;
+  if (count == 0)
+    return true;
+
+  if (batch->segment_count == batch->segment_capacity) {
+    int new_capacity = batch->segment_capacity ? batch->segment_capacity * 2 : 4;
+    TextBatchSegment *segments =
+        realloc(batch->segments, new_capacity * sizeof(TextBatchSegment));
+    if (!segments)
+      return false;
+    batch->segments = segments;
+    batch->segment_capacity = new_capacity;
+  }
+
+  TextBatchSegment *segment = &batch->segments[batch->segment_count];
+  if (!gpu_ring_upload(&renderer->geometry_ring, batch->instances,
+                       count * sizeof(TextGlyphInstance), &segment->alloc)) {
+    LOG_ERROR("上传文本批次段失败\n");
+    return false;
+  }
+  segment->first = batch->segment_first;
+  segment->count = count;
+  batch->segment_count++;
+  batch->segment_first = batch->char_count;
+  return true;
+}
+
+static void reset_batch(TextRenderBatch *batch) {
+  batch->char_count = 0;
+  batch->segment_first = 0;
+  batch->segment_count = 0;
+}
+
+// 确保当前段能再容纳一个字符：先翻倍扩容，达到段上限后封存并开始新段
+static bool reserve_batch(TextRenderer *renderer) {
+  TextRenderBatch *batch = &renderer->current_batch;
+  int used = batch->char_count - batch->segment_first;
+  if (used < batch->char_capacity)
+    return true;
+  if (batch->char_capacity >= TEXT_MAX_CHARS_PER_BATCH)
+    return seal_batch_segment(renderer);
+
+  int new_capacity = batch->char_capacity * 2;
+  if (new_capacity > TEXT_MAX_CHARS_PER_BATCH)
+    new_capacity = TEXT_MAX_CHARS_PER_BATCH;
+
+  TextGlyphInstance *instances =
+      realloc(batch->instances, new_capacity * sizeof(TextGlyphInstance));
+  if (!instances)
+    return false;
+  batch->instances = instances;
+
+  batch->char_capacity = new_capacity;
+  return true;
+}
+
+static bool create_bind_group(TextRenderer *renderer) {
+  if (!text_bind_group_layout || !renderer->atlas.texture_view ||
+      !renderer->atlas.sampler) {
+    LOG_ERROR("创建绑定组失败：缺少必要资源\n");
+    return false;
+  }
+
+  WGPUBindGroupEntry bind_group_entries[] = {
+      {.binding = 0, .textureView = renderer->atlas.texture_view},
+      {.binding = 1, .sampler = renderer->atlas.sampler},
+      {.binding = 2,
+       .buffer = renderer->glyph_table_buffer,
+       .size = sizeof(renderer->gpu_glyphs)},
+      {.binding = 3,
+       .buffer = renderer->screen_uniform_buffer,
+       .size = 4 * sizeof(float)}};
+
+  WGPUBindGroupDescriptor bind_group_desc = {
+      .label = {.data = "Text Bind Group", .length = WGPU_STRLEN},
+      .layout = text_bind_group_layout,
+      .entryCount = 4,
+      .entries = bind_group_entries};
+
+  WGPUBindGroup bind_group =
+      wgpuDeviceCreateBindGroup(renderer->device, &bind_group_desc);
+
+  if (!bind_group) {
+    LOG_ERROR("创建文本绑定组失败\n");
+    return false;
+  }
+
+  // 纹理重建后替换旧绑定组（已录制的命令仍持有旧绑定组的引用）
+  if (renderer->atlas.bind_group)
+    wgpuBindGroupRelease(renderer->atlas.bind_group);
+  renderer->atlas.bind_group = bind_group;
+
+  LOG_DEBUG("文本绑定组创建成功\n");
+  return true;
+}
+
+// 创建 layers 层的图集纹理数组，已有纹理时在GPU上复制已用的页，不重新上传
+static bool create_atlas_texture(TextRenderer *renderer, int layers) {
   WGPUTextureDescriptor texture_desc = {
       .label = {.data = "Text Atlas Texture", .length = WGPU_STRLEN},
-      .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
+      .usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst |
+               WGPUTextureUsage_CopySrc,
       .dimension = WGPUTextureDimension_2D,
-      .size = {TEXT_ATLAS_WIDTH, TEXT_ATLAS_HEIGHT, 1},
+      .size = {TEXT_ATLAS_PAGE_SIZE, TEXT_ATLAS_PAGE_SIZE, (uint32_t)layers},
       .format = WGPUTextureFormat_R8Unorm,
       .mipLevelCount = 1,
       .sampleCount = 1};
 
-  renderer->atlas.texture =
+  WGPUTexture texture =
       wgpuDeviceCreateTexture(renderer->device, &texture_desc);
-  if (!renderer->atlas.texture)
+  if (!texture)
     return false;
 
-  // 创建纹理视图
-  renderer->atlas.texture_view =
-      wgpuTextureCreateView(renderer->atlas.texture, NULL);
-  if (!renderer->atlas.texture_view)
+  // 显式指定数组视图：只有一层时默认视图是普通2D纹理
+  WGPUTextureViewDescriptor view_desc = {
+      .label = {.data = "Text Atlas View", .length = WGPU_STRLEN},
+      .format = WGPUTextureFormat_R8Unorm,
+      .dimension = WGPUTextureViewDimension_2DArray,
+      .baseMipLevel = 0,
+      .mipLevelCount = 1,
+      .baseArrayLayer = 0,
+      .arrayLayerCount = (uint32_t)layers,
+      .aspect = WGPUTextureAspect_All};
+  WGPUTextureView texture_view = wgpuTextureCreateView(texture, &view_desc);
+  if (!texture_view) {
+    wgpuTextureRelease(texture);
+    return false;
+  }
+
+  TextAtlas *atlas = &renderer->atlas;
+  if (atlas->texture && atlas->page_count > 0) {
+    // 尚未上传的脏区域留在各页中，之后直接写入新纹理
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(
+        renderer->device,
+        &(WGPUCommandEncoderDescriptor){
+            .label = {.data = "Text Atlas Grow", .length = WGPU_STRLEN}});
+    wgpuCommandEncoderCopyTextureToTexture(
+        encoder,
+        &(WGPUTexelCopyTextureInfo){.texture = atlas->texture,
+                                    .aspect = WGPUTextureAspect_All},
+        &(WGPUTexelCopyTextureInfo){.texture = texture,
+                                    .aspect = WGPUTextureAspect_All},
+        &(WGPUExtent3D){TEXT_ATLAS_PAGE_SIZE, TEXT_ATLAS_PAGE_SIZE,
+                        (uint32_t)atlas->page_count});
+    WGPUCommandBuffer commands = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuQueueSubmit(renderer->queue, 1, &commands);
+    wgpuCommandBufferRelease(commands);
+    wgpuCommandEncoderRelease(encoder);
+  }
+
+  if (atlas->texture_view)
+    wgpuTextureViewRelease(atlas->texture_view);
+  if (atlas->texture)
+    wgpuTextureRelease(atlas->texture);
+  atlas->texture = texture;
+  atlas->texture_view = texture_view;
+  atlas->layer_capacity = layers;
+
+  // 初始化时绑定组尚未创建；之后每次扩容都要重建
+  return !atlas->bind_group || create_bind_group(renderer);
+}
+
+// 追加一页，纹理层数不够时按倍数扩容
+static TextAtlasPage *add_atlas_page(TextRenderer *renderer) {
+  TextAtlas *atlas = &renderer->atlas;
+  if (atlas->page_count == TEXT_ATLAS_MAX_PAGES)
+    return NULL;
+
+  if (atlas->page_count == atlas->layer_capacity) {
+    int layers = atlas->layer_capacity * 2;
+    if (layers > TEXT_ATLAS_MAX_PAGES)
+      layers = TEXT_ATLAS_MAX_PAGES;
+    if (!create_atlas_texture(renderer, layers)) {
+      LOG_ERROR("扩容字体图集纹理失败（%d 层）\n", layers);
+      return NULL;
+    }
+  }
+
+  TextAtlasPage *page = calloc(1, sizeof(TextAtlasPage));
+  if (!page)
+    return NULL;
+  page->pixels = calloc(TEXT_ATLAS_PAGE_SIZE * TEXT_ATLAS_PAGE_SIZE, 1);
+  if (!page->pixels) {
+    free(page);
+    return NULL;
+  }
+  atlas_packer_init(&page->packer, TEXT_ATLAS_PAGE_SIZE, TEXT_ATLAS_PAGE_SIZE);
+
+  atlas->pages[atlas->page_count++] = page;
+  LOG_DEBUG("字体图集新增第 %d 页\n", atlas->page_count);
+  return page;
+}
+
+// 创建纹理图集：初始只有一页
+static bool create_atlas(TextRenderer *renderer) {
+  if (!create_atlas_texture(renderer, 1))
     return false;
 
   // 创建采样器
@@ -361,49 +725,187 @@ static bool create_atlas(TextRenderer *renderer) {
   if (!renderer->atlas.sampler)
     return false;
 
-  // 分配像素缓冲区
-  renderer->atlas.pixels = calloc(TEXT_ATLAS_WIDTH * TEXT_ATLAS_HEIGHT, 1);
-  if (!renderer->atlas.pixels)
-    return false;
-
-  // 初始化图集状态
-  renderer->atlas.current_x = 0;
-  renderer->atlas.current_y = 0;
-  renderer->atlas.line_height = 0;
   renderer->atlas.dirty = false;
+  return add_atlas_page(renderer) != NULL;
+}
 
-  return true;
+// 在已有的页中分配，成功时写入所在页
+static bool alloc_in_atlas_pages(TextRenderer *renderer, int width, int height,
+                                 AtlasPackerRect *out_rect, int *out_shelf,
+                                 int *out_layer) {
+  for (int i = 0; i < renderer->atlas.page_count; i++) {
+    if (atlas_packer_alloc(&renderer->atlas.pages[i]->packer, width, height,
+                           out_rect, out_shelf)) {
+      *out_layer = i;
+      return true;
+    }
+  }
+  return false;
 }
 
-static bool create_bind_group(TextRenderer *renderer) {
-  if (!text_bind_group_layout || !renderer->atlas.texture_view ||
-      !renderer->atlas.sampler) {
-    Log("创建绑定组失败：缺少必要资源\n");
-    return false;
+// 为字形分配图集空间：现有页都放不下时加页，页数用满后先淘汰长时间未用的字形，
+// 仍不足则淘汰本帧之前的所有字形（本帧已写入批次的字形均已刷新LRU时间，不受影响）
+static bool alloc_atlas_rect(TextRenderer *renderer, int width, int height,
+                             AtlasPackerRect *out_rect, int *out_shelf,
+                             int *out_layer) {
+  if (alloc_in_atlas_pages(renderer, width, height, out_rect, out_shelf,
+                           out_layer))
+    return true;
+
+  TextAtlasPage *page = add_atlas_page(renderer);
+  if (page && atlas_packer_alloc(&page->packer, width, height, out_rect,
+                                 out_shelf)) {
+    *out_layer = renderer->atlas.page_count - 1;
+    return true;
   }
 
-  WGPUBindGroupEntry bind_group_entries[] = {
-      {.binding = 0, .textureView = renderer->atlas.texture_view},
-      {.binding = 1, .sampler = renderer->atlas.sampler}};
+  if (evict_glyphs(renderer, TEXT_ATLAS_EVICT_FRAMES) > 0 &&
+      alloc_in_atlas_pages(renderer, width, height, out_rect, out_shelf,
+                           out_layer))
+    return true;
 
-  WGPUBindGroupDescriptor bind_group_desc = {
-      .label = {.data = "Text Bind Group", .length = WGPU_STRLEN},
-      .layout = text_bind_group_layout,
-      .entryCount = 2,
-      .entries = bind_group_entries};
+  return evict_glyphs(renderer, 1) > 0 &&
+         alloc_in_atlas_pages(renderer, width, height, out_rect, out_shelf,
+                              out_layer);
+}
 
-  renderer->atlas.bind_group =
-      wgpuDeviceCreateBindGroup(renderer->device, &bind_group_desc);
+// 字体内容哈希：只哈希文件大小、开头64KB与末尾4KB，不触碰映射的其余页面
+// 开头包含表目录，其中每张表都带有校验和，因此任何表的变化都会反映到哈希中
+#define FONT_HASH_HEAD_BYTES (64 * 1024)
+#define FONT_HASH_TAIL_BYTES (4 * 1024)
+
+static uint64_t hash_bytes(uint64_t hash, const unsigned char *data,
+                           size_t size) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * 0x100000001B3ull;
+    hash ^= hash >> 29;
+  }
+  for (; i < size; i++) {
+    hash = (hash ^ data[i]) * 0x100000001B3ull;
+  }
+  return hash;
+}
+
+static uint64_t hash_font_data(const unsigned char *data, size_t size,
+                               int face_index) {
+  uint64_t hash = 0x9E3779B97F4A7C15ull ^ size;
+  hash ^= (uint64_t)face_index * 0xC2B2AE3D27D4EB4Full;
+
+  size_t head = size < FONT_HASH_HEAD_BYTES ? size : FONT_HASH_HEAD_BYTES;
+  hash = hash_bytes(hash, data, head);
+  if (size > head) {
+    size_t tail = size - head < FONT_HASH_TAIL_BYTES ? size - head
+                                                     : FONT_HASH_TAIL_BYTES;
+    hash = hash_bytes(hash, data + size - tail, tail);
+  }
+  return hash ^ (hash >> 32);
+}
+
+// 获取字体文件映射：同一路径只映射一次，引用计数加一
+static int acquire_font_file(TextRenderer *renderer, const char *font_path) {
+  int free_slot = -1;
+  for (int i = 0; i < TEXT_MAX_FONTS; i++) {
+    FontFile *file = &renderer->font_files[i];
+    if (file->ref_count > 0 && strcmp(file->path, font_path) == 0) {
+      file->ref_count++;
+      return i;
+    }
+    if (file->ref_count == 0 && free_slot < 0)
+      free_slot = i;
+  }
+
+  if (free_slot < 0 ||
+      !font_file_open(&renderer->font_files[free_slot], font_path))
+    return -1;
+  return free_slot;
+}
+
+static void release_font_file(TextRenderer *renderer, int file_index) {
+  if (file_index < 0 || file_index >= TEXT_MAX_FONTS)
+    return;
+
+  FontFile *file = &renderer->font_files[file_index];
+  if (file->ref_count > 0 && --file->ref_count == 0)
+    font_file_close(file);
+}
+
+// 首次使用时解析字体表并计算度量
+static bool init_font_face(TextRenderer *renderer, TextFont *font) {
+  if (font->face_ready)
+    return true;
+
+  // stb_truetype 只读取数据，映射是只读的
+  FontFile *file = &renderer->font_files[font->file_index];
+  if (!stbtt_InitFont(&font->font_info, (unsigned char *)file->data,
+                      font->face_offset)) {
+    LOG_ERROR("初始化字体失败: %s (face %d)\n", font->font_path,
+              font->face_index);
+    font->loaded = false;
+    return false;
+  }
 
-  if (!renderer->atlas.bind_group) {
-    Log("创建文本绑定组失败\n");
+  // 覆盖索引与字体表一同构建，之后的回退查找不再遍历 cmap
+  if (!font_coverage_build(&font->coverage, &font->font_info, file->size)) {
+    LOG_ERROR("构建字体覆盖索引失败: %s\n", font->font_path);
+    font_coverage_free(&font->coverage);
+    font->loaded = false;
     return false;
   }
 
-  Log("文本绑定组创建成功\n");
+  // 拉丁字符的字形索引与前进宽度直接查表
+  for (int cp = 0; cp < TEXT_LATIN_TABLE_SIZE; cp++) {
+    int glyph = font_coverage_glyph(&font->coverage, (uint32_t)cp);
+    int advance = 0;
+    if (glyph)
+      stbtt_GetGlyphHMetrics(&font->font_info, glyph, &advance, NULL);
+    font->latin_glyphs[cp] = (uint16_t)glyph;
+    font->latin_advances[cp] = (int16_t)advance;
+  }
+
+  // 字距对表构建失败只影响排版精度，不影响字体可用性
+  if (!font_kerning_build(&font->kerning, &font->font_info, &font->coverage)) {
+    LOG_WARN("构建字距调整表失败，该字体不应用字距: %s\n", font->font_path);
+  }
+
+  font->scale = stbtt_ScaleForPixelHeight(&font->font_info, font->font_size);
+
+  // 获取字体度量信息
+  stbtt_GetFontVMetrics(&font->font_info, &font->ascent, &font->descent,
+                        &font->line_gap);
+  font->line_height =
+      (font->ascent - font->descent + font->line_gap) * font->scale;
+  font->face_ready = true;
+
+  LOG_DEBUG("字体face初始化: %s (ID: %d, face %d, 覆盖 %d 个码点, "
+            "%d 个字距对)\n",
+            font->font_path, font->font_id, font->face_index,
+            font->coverage.codepoint_count, font->kerning.pair_count);
   return true;
 }
 
+// 释放所有文本段
+static void clear_text_runs(TextRenderer *renderer) {
+  for (int i = 0; i < TEXT_RUN_CACHE_SIZE; i++) {
+    free(renderer->run_cache[i].glyphs);
+  }
+  memset(renderer->run_cache, 0, sizeof(renderer->run_cache));
+}
+
+// 释放长时间未绘制的文本段
+static void evict_text_runs(TextRenderer *renderer) {
+  for (int i = 0; i < TEXT_RUN_CACHE_SIZE; i++) {
+    TextRun *run = &renderer->run_cache[i];
+    if (run->hash != 0 &&
+        renderer->frame_index - run->last_used_frame > TEXT_RUN_EVICT_FRAMES) {
+      free(run->glyphs);
+      memset(run, 0, sizeof(TextRun));
+    }
+  }
+}
+
 // API实现
 
 TextRenderer *text_renderer_create(WGPUDevice device, WGPUQueue queue,
@@ -420,16 +922,16 @@ TextRenderer *text_renderer_create(WGPUDevice device, WGPUQueue queue,
   renderer->default_font_id = -1;
 
   // 分配批次缓冲区
-  renderer->current_batch.vertex_data =
-      malloc(TEXT_MAX_CHARS_PER_BATCH * 4 * 8 * sizeof(float));
-  renderer->current_batch.index_data =
-      malloc(TEXT_MAX_CHARS_PER_BATCH * 6 * sizeof(uint16_t));
+  renderer->current_batch.char_capacity = TEXT_INITIAL_BATCH_CHARS;
+  renderer->current_batch.instances =
+      malloc(TEXT_INITIAL_BATCH_CHARS * sizeof(TextGlyphInstance));
 
-  if (!renderer->current_batch.vertex_data ||
-      !renderer->current_batch.index_data) {
+  if (!renderer->current_batch.instances ||
+      !glyph_table_init(&renderer->glyph_lookup, TEXT_GLYPH_INDEX_SIZE)) {
     text_renderer_destroy(renderer);
     return NULL;
   }
+  reset_gpu_slots(renderer);
 
   // 创建WebGPU资源
   if (!create_text_pipeline(renderer) || !create_buffers(renderer) ||
@@ -438,7 +940,12 @@ TextRenderer *text_renderer_create(WGPUDevice device, WGPUQueue queue,
     return NULL;
   }
 
-  Log("文本渲染器创建成功\n");
+  // 后台光栅化线程创建失败时退回同步光栅化
+  renderer->rasterizer = glyph_rasterizer_create(0);
+  renderer->async_raster = renderer->rasterizer != NULL;
+
+  Log("文本渲染器创建成功（光栅化线程: %d）\n",
+      glyph_rasterizer_worker_count(renderer->rasterizer));
   return renderer;
 }
 
@@ -446,17 +953,30 @@ void text_renderer_destroy(TextRenderer *renderer) {
   if (!renderer)
     return;
 
+  // 先停止光栅化线程，它们读取字体数据
+  glyph_rasterizer_destroy(renderer->rasterizer);
+
   // 释放批次缓冲区
-  free(renderer->current_batch.vertex_data);
-  free(renderer->current_batch.index_data);
+  free(renderer->current_batch.instances);
+  free(renderer->current_batch.segments);
+  glyph_table_free(&renderer->glyph_lookup);
+
+  // 释放文本段几何缓存
+  clear_text_runs(renderer);
+  free(renderer->run_scratch);
 
-  // 释放字体资源
+  // 释放字体文件映射
   for (int i = 0; i < renderer->font_count; i++) {
-    free(renderer->fonts[i].font_buffer);
+    font_coverage_free(&renderer->fonts[i].coverage);
+    font_kerning_free(&renderer->fonts[i].kerning);
+    release_font_file(renderer, renderer->fonts[i].file_index);
   }
 
   // 释放图集资源
-  free(renderer->atlas.pixels);
+  for (int i = 0; i < renderer->atlas.page_count; i++) {
+    free(renderer->atlas.pages[i]->pixels);
+    free(renderer->atlas.pages[i]);
+  }
   if (renderer->atlas.bind_group)
     wgpuBindGroupRelease(renderer->atlas.bind_group);
   if (renderer->atlas.sampler)
@@ -467,14 +987,17 @@ void text_renderer_destroy(TextRenderer *renderer) {
     wgpuTextureRelease(renderer->atlas.texture);
 
   // 释放缓冲区
-  if (renderer->index_buffer)
-    wgpuBufferRelease(renderer->index_buffer);
-  if (renderer->vertex_buffer)
-    wgpuBufferRelease(renderer->vertex_buffer);
+  gpu_ring_destroy(&renderer->geometry_ring);
+  if (renderer->glyph_table_buffer)
+    wgpuBufferRelease(renderer->glyph_table_buffer);
+  if (renderer->screen_uniform_buffer)
+    wgpuBufferRelease(renderer->screen_uniform_buffer);
 
   // 释放管线
   if (renderer->text_pipeline)
     wgpuRenderPipelineRelease(renderer->text_pipeline);
+  if (renderer->sdf_pipeline)
+    wgpuRenderPipelineRelease(renderer->sdf_pipeline);
 
   // 释放全局绑定组布局（只在最后一个实例销毁时释放）
   if (text_bind_group_layout) {
@@ -494,68 +1017,60 @@ void text_renderer_update_screen_size(TextRenderer *renderer,
 
   renderer->screen_width = screen_width;
   renderer->screen_height = screen_height;
+  write_screen_uniform(renderer);
 }
 
 int text_renderer_load_font(TextRenderer *renderer, const char *font_path,
                             int font_size) {
-  if (!renderer || renderer->font_count >= TEXT_MAX_FONTS)
-    return -1;
+  return text_renderer_load_font_face(renderer, font_path, 0, font_size);
+}
 
-  // 读取字体文件
-  FILE *file = fopen(font_path, "rb");
-  if (!file) {
-    Log("无法打开字体文件: %s\n", font_path);
+int text_renderer_load_font_face(TextRenderer *renderer, const char *font_path,
+                                 int face_index, int font_size) {
+  if (!renderer || !font_path || face_index < 0)
     return -1;
-  }
 
-  fseek(file, 0, SEEK_END);
-  long file_size = ftell(file);
-  fseek(file, 0, SEEK_SET);
+  // 字号在渲染时按需栅格化，同一字体（文件 + face）只加载一次
+  for (int i = 0; i < renderer->font_count; i++) {
+    if (renderer->fonts[i].loaded &&
+        renderer->fonts[i].face_index == face_index &&
+        strcmp(renderer->fonts[i].font_path, font_path) == 0) {
+      Log("字体已加载，复用: %s (ID: %d)\n", font_path, i);
+      return i;
+    }
+  }
 
-  if (file_size <= 0) {
-    fclose(file);
-    Log("字体文件大小无效: %s\n", font_path);
+  if (renderer->font_count >= TEXT_MAX_FONTS)
     return -1;
-  }
 
-  unsigned char *font_buffer = malloc(file_size);
-  if (!font_buffer) {
-    fclose(file);
+  // 映射字体文件：这里只读取文件头，字形数据在使用时才按页读入
+  int file_index = acquire_font_file(renderer, font_path);
+  if (file_index < 0) {
+    LOG_WARN("无法打开字体文件: %s\n", font_path);
     return -1;
   }
 
-  size_t read_size = fread(font_buffer, 1, file_size, file);
-  fclose(file);
-
-  if (read_size != file_size) {
-    free(font_buffer);
-    Log("读取字体文件失败: %s\n", font_path);
+  FontFile *file = &renderer->font_files[file_index];
+  int face_offset =
+      file->size >= 12 ? stbtt_GetFontOffsetForIndex(file->data, face_index)
+                       : -1;
+  if (face_offset < 0 || (size_t)face_offset >= file->size) {
+    release_font_file(renderer, file_index);
+    LOG_ERROR("不是有效的字体文件或不包含 face %d: %s\n", face_index,
+              font_path);
     return -1;
   }
 
-  // 初始化字体
+  // 字体表的解析推迟到首次使用（init_font_face）
   TextFont *font = &renderer->fonts[renderer->font_count];
   memset(font, 0, sizeof(TextFont));
-
-  if (!stbtt_InitFont(&font->font_info, font_buffer, 0)) {
-    free(font_buffer);
-    Log("初始化字体失败: %s\n", font_path);
-    return -1;
-  }
-
-  // 设置字体信息
   font->font_id = renderer->font_count;
   strncpy(font->font_path, font_path, sizeof(font->font_path) - 1);
   font->font_size = font_size;
-  font->font_buffer = font_buffer;
-  font->font_buffer_size = file_size;
-  font->scale = stbtt_ScaleForPixelHeight(&font->font_info, font_size);
-
-  // 获取字体度量信息
-  stbtt_GetFontVMetrics(&font->font_info, &font->ascent, &font->descent,
-                        &font->line_gap);
-  font->line_height =
-      (font->ascent - font->descent + font->line_gap) * font->scale;
+  font->file_index = file_index;
+  font->face_index = face_index;
+  font->face_offset = face_offset;
+  font->content_hash = hash_font_data(file->data, file->size, face_index);
   font->loaded = true;
 
   int font_id = renderer->font_count++;
@@ -565,7 +1080,8 @@ int text_renderer_load_font(TextRenderer *renderer, const char *font_path,
     renderer->default_font_id = font_id;
   }
 
-  Log("字体加载成功: %s (ID: %d, 大小: %d)\n", font_path, font_id, font_size);
+  Log("字体加载成功: %s (ID: %d, face %d, 大小: %d, %s)\n", font_path, font_id,
+      face_index, font_size, file->mapped ? "内存映射" : "读入内存");
   return font_id;
 }
 
@@ -577,34 +1093,127 @@ bool text_renderer_set_default_font(TextRenderer *renderer, int font_id) {
   return true;
 }
 
+bool text_renderer_add_fallback_font(TextRenderer *renderer, int font_id) {
+  if (!renderer || font_id < 0 || font_id >= renderer->font_count ||
+      !renderer->fonts[font_id].loaded)
+    return false;
+
+  for (int i = 0; i < renderer->fallback_count; i++) {
+    if (renderer->fallback_fonts[i] == font_id)
+      return true;
+  }
+  if (renderer->fallback_count >= TEXT_MAX_FONTS)
+    return false;
+
+  renderer->fallback_fonts[renderer->fallback_count++] = font_id;
+  // 回退链变化会改变缺字的度量与字形，已排版的文本段与ASCII直接索引随之失效
+  memset(renderer->measure_cache, 0, sizeof(renderer->measure_cache));
+  renderer->atlas_generation++;
+  Log("回退字体: %s (ID: %d, 第 %d 位)\n", renderer->fonts[font_id].font_path,
+      font_id, renderer->fallback_count);
+  return true;
+}
+
 TextFont *text_renderer_get_font(TextRenderer *renderer, int font_id) {
   if (!renderer || font_id < 0 || font_id >= renderer->font_count)
     return NULL;
-  return &renderer->fonts[font_id];
+
+  TextFont *font = &renderer->fonts[font_id];
+  return font->loaded && init_font_face(renderer, font) ? font : NULL;
 }
 
-TextGlyph *text_renderer_get_glyph(TextRenderer *renderer, uint32_t codepoint,
-                                   int font_id) {
-  if (!renderer)
+int text_renderer_raster_size(int font_size) {
+  if (font_size <= TEXT_EXACT_SIZE_LIMIT)
+    return font_size;
+
+  // 字号越大，相邻字号之间的差异越不明显，步长随之增大
+  int step = font_size <= 64 ? 4 : (font_size <= 128 ? 8 : 16);
+  int raster_size = (font_size + step / 2) / step * step;
+  return raster_size > TEXT_MAX_RASTER_SIZE ? TEXT_MAX_RASTER_SIZE
+                                            : raster_size;
+}
+
+float text_renderer_font_scale(const TextFont *font, int font_size) {
+  if (font_size <= 0 || font_size == font->font_size)
+    return font->scale;
+  return stbtt_ScaleForPixelHeight(&font->font_info, (float)font_size);
+}
+
+// 字形缓存使用的字号键：SDF模式下所有字号共用一份距离场
+static int glyph_size_key(const TextRenderer *renderer, int font_size) {
+  return renderer->sdf_mode ? TEXT_SDF_SIZE_KEY
+                            : text_renderer_raster_size(font_size);
+}
+
+// 请求字号相对于缓存字形的缩放比例
+static float glyph_size_ratio(const TextRenderer *renderer, int font_size) {
+  int raster_size = renderer->sdf_mode ? TEXT_SDF_BASE_SIZE
+                                       : text_renderer_raster_size(font_size);
+  return (float)font_size / raster_size;
+}
+
+// 解析字体ID与字号：无效字体回退到默认字体，未指定字号时使用字体默认字号
+static TextFont *resolve_font(TextRenderer *renderer, int *font_id,
+                              int *font_size) {
+  if (*font_id < 0 || *font_id >= renderer->font_count ||
+      !renderer->fonts[*font_id].loaded)
+    *font_id = renderer->default_font_id;
+  if (*font_id < 0 || *font_id >= renderer->font_count)
     return NULL;
 
-  // 使用默认字体如果没有指定字体
-  if (font_id < 0)
-    font_id = renderer->default_font_id;
-  if (font_id < 0 || font_id >= renderer->font_count)
+  TextFont *font = &renderer->fonts[*font_id];
+  if (!init_font_face(renderer, font))
     return NULL;
+  if (*font_size <= 0)
+    *font_size = font->font_size;
+  return font;
+}
+
+// 选择实际绘制码点的字体并解析字形索引：请求字体不包含该码点时沿回退链查找，
+// 都不包含时仍使用请求字体（绘制 .notdef，与其他字形一样只生成一次）
+static int resolve_glyph_font(TextRenderer *renderer, int font_id,
+                              uint32_t codepoint, uint32_t *glyph_index) {
+  *glyph_index =
+      font_coverage_glyph(&renderer->fonts[font_id].coverage, codepoint);
+  if (*glyph_index)
+    return font_id;
+
+  for (int i = 0; i < renderer->fallback_count; i++) {
+    int fallback_id = renderer->fallback_fonts[i];
+    TextFont *fallback = &renderer->fonts[fallback_id];
+    if (fallback_id == font_id || !fallback->loaded ||
+        !init_font_face(renderer, fallback))
+      continue;
+    int fallback_glyph = font_coverage_glyph(&fallback->coverage, codepoint);
+    if (fallback_glyph) {
+      *glyph_index = fallback_glyph;
+      return fallback_id;
+    }
+  }
+  return font_id;
+}
+
+// 按字形索引查找，未命中时生成（font_id 与 font_size 已解析）
+static TextGlyph *find_or_generate_glyph(TextRenderer *renderer,
+                                         uint32_t glyph_index, int font_id,
+                                         int font_size) {
+  int pixel_size = glyph_size_key(renderer, font_size);
 
   // 在缓存中查找
   TextGlyphCacheEntry *entry =
-      find_glyph_cache_entry(renderer, codepoint, font_id);
+      find_glyph_cache_entry(renderer, glyph_index, font_id, pixel_size);
   if (entry) {
     return &entry->glyph;
   }
 
   // 尝试动态生成字形
   renderer->cache_misses++;
-  if (text_renderer_generate_glyph(renderer, codepoint, font_id)) {
-    entry = find_glyph_cache_entry(renderer, codepoint, font_id);
+  double generation_start = GetTimeMs();
+  bool generated =
+      text_renderer_generate_glyph(renderer, glyph_index, font_id, pixel_size);
+  renderer->glyph_generation_ms += GetTimeMs() - generation_start;
+  if (generated) {
+    entry = find_glyph_cache_entry(renderer, glyph_index, font_id, pixel_size);
     if (entry)
       return &entry->glyph;
   }
@@ -612,109 +1221,633 @@ TextGlyph *text_renderer_get_glyph(TextRenderer *renderer, uint32_t codepoint,
   return NULL;
 }
 
-bool text_renderer_generate_glyph(TextRenderer *renderer, uint32_t codepoint,
-                                  int font_id) {
-  if (!renderer || font_id < 0 || font_id >= renderer->font_count)
-    return false;
-
-  TextFont *font = &renderer->fonts[font_id];
-  if (!font->loaded)
-    return false;
+// 返回字体在该字号下的ASCII直接索引行，没有时替换一行
+static TextAsciiGlyphs *ascii_glyph_row(TextRenderer *renderer, TextFont *font,
+                                        int pixel_size) {
+  TextAsciiGlyphs *row = NULL;
+  for (int i = 0; i < TEXT_ASCII_GLYPH_ROWS; i++) {
+    if (font->ascii_glyphs[i].pixel_size == pixel_size) {
+      row = &font->ascii_glyphs[i];
+      break;
+    }
+  }
+  if (!row) {
+    row = &font->ascii_glyphs[font->ascii_next_row];
+    font->ascii_next_row = (font->ascii_next_row + 1) % TEXT_ASCII_GLYPH_ROWS;
+    row->generation = renderer->atlas_generation - 1; // 强制下面清空
+  }
+  if (row->generation != renderer->atlas_generation) {
+    row->pixel_size = pixel_size;
+    row->generation = renderer->atlas_generation;
+    memset(row->slots, 0, sizeof(row->slots));
+  }
+  return row;
+}
+
+// 按码点取字形：ASCII码点先查请求字体的直接索引表，命中时只访问一次条目；
+// glyph_font 与 glyph_index 为 resolve_glyph_font 的结果
+static TextGlyph *find_or_generate_codepoint_glyph(TextRenderer *renderer,
+                                                   int font_id,
+                                                   uint32_t codepoint,
+                                                   int glyph_font,
+                                                   uint32_t glyph_index,
+                                                   int font_size) {
+  if (codepoint >= 128)
+    return find_or_generate_glyph(renderer, glyph_index, glyph_font,
+                                  font_size);
+
+  TextAsciiGlyphs *row = ascii_glyph_row(
+      renderer, &renderer->fonts[font_id], glyph_size_key(renderer, font_size));
+  if (row->slots[codepoint]) {
+    TextGlyphCacheEntry *entry =
+        &renderer->glyph_cache[row->slots[codepoint] - 1];
+    renderer->cache_hits++;
+    entry->last_used_frame = renderer->frame_index;
+    return &entry->glyph;
+  }
+
+  TextGlyph *glyph =
+      find_or_generate_glyph(renderer, glyph_index, glyph_font, font_size);
+  // 生成过程中淘汰了字形时本行已作废，下次查找会重新清空
+  if (glyph && row->generation == renderer->atlas_generation)
+    row->slots[codepoint] = glyph->gpu_slot + 1;
+  return glyph;
+}
+
+TextGlyph *text_renderer_get_glyph(TextRenderer *renderer, uint32_t codepoint,
+                                   int font_id, int font_size) {
+  if (!renderer)
+    return NULL;
+
+  // 使用默认字体如果没有指定字体
+  if (!resolve_font(renderer, &font_id, &font_size))
+    return NULL;
+
+  // 码点只在覆盖索引中解析一次，之后的缓存与stb调用都使用字形索引
+  uint32_t glyph_index;
+  int glyph_font =
+      resolve_glyph_font(renderer, font_id, codepoint, &glyph_index);
+  return find_or_generate_codepoint_glyph(renderer, font_id, codepoint,
+                                          glyph_font, glyph_index, font_size);
+}
+
+TextGlyph *text_renderer_get_glyph_by_index(TextRenderer *renderer,
+                                            uint32_t glyph_index, int font_id,
+                                            int font_size) {
+  if (!renderer)
+    return NULL;
+
+  if (!resolve_font(renderer, &font_id, &font_size))
+    return NULL;
+  return find_or_generate_glyph(renderer, glyph_index, font_id, font_size);
+}
+
+// 相邻字形之间的字距调整（请求字号下的像素）
+// 测量与绘制共用，保证 Clay 的布局与实际绘制一致；来自不同字体（回退）的
+// 相邻字形之间不调整
+static float kerning_adjustment(TextRenderer *renderer, int left_font,
+                                uint32_t left_glyph, int right_font,
+                                uint32_t right_glyph, int font_size) {
+  if (left_font < 0 || left_font != right_font)
+    return 0.0f;
+
+  TextFont *font = &renderer->fonts[right_font];
+  int advance = font_kerning_advance(&font->kerning, left_glyph, right_glyph);
+  return advance ? advance * text_renderer_font_scale(font, font_size) : 0.0f;
+}
+
+// 只读取度量的字形解析：不查字形缓存、不光栅化，返回请求字号下的前进宽度
+// scale 为 font_id 在请求字号下的缩放；测量与绘制都用它推进光标
+static float glyph_metrics_advance(TextRenderer *renderer, uint32_t codepoint,
+                                   int font_id, int font_size, float scale,
+                                   int *glyph_font, uint32_t *glyph_index) {
+  TextFont *font = &renderer->fonts[font_id];
+  if (codepoint < TEXT_LATIN_TABLE_SIZE && font->latin_glyphs[codepoint]) {
+    *glyph_font = font_id;
+    *glyph_index = font->latin_glyphs[codepoint];
+    return font->latin_advances[codepoint] * scale;
+  }
+
+  *glyph_font = resolve_glyph_font(renderer, font_id, codepoint, glyph_index);
+  TextFont *face = &renderer->fonts[*glyph_font];
+  int advance = 0;
+  stbtt_GetGlyphHMetrics(&face->font_info, (int)*glyph_index, &advance, NULL);
+  return advance * (*glyph_font == font_id
+                        ? scale
+                        : text_renderer_font_scale(face, font_size));
+}
+
+static int atlas_rect_area(AtlasPackerRect rect) {
+  return rect.width * rect.height;
+}
 
-  // 获取字符边界框
+static AtlasPackerRect atlas_rect_union(AtlasPackerRect a, AtlasPackerRect b) {
+  int x0 = a.x < b.x ? a.x : b.x;
+  int y0 = a.y < b.y ? a.y : b.y;
+  int x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+  int y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+  return (AtlasPackerRect){x0, y0, x1 - x0, y1 - y0};
+}
+
+// 记录页内脏区域并尽量合并：合并后的面积不超过两者之和的两倍时并入已有区域，
+// 同一行中相邻的字形因此会合并成一条带状区域
+static void mark_atlas_dirty(TextAtlas *atlas, int layer, AtlasPackerRect rect) {
+  TextAtlasPage *page = atlas->pages[layer];
+  atlas->dirty = true;
+
+  for (int i = 0; i < page->dirty_rect_count; i++) {
+    AtlasPackerRect merged = atlas_rect_union(page->dirty_rects[i], rect);
+    if (atlas_rect_area(merged) <=
+        2 * (atlas_rect_area(page->dirty_rects[i]) + atlas_rect_area(rect))) {
+      page->dirty_rects[i] = merged;
+      return;
+    }
+  }
+
+  // 区域数量达到上限时全部合并为一个包围矩形
+  if (page->dirty_rect_count == TEXT_ATLAS_MAX_DIRTY_RECTS) {
+    for (int i = 1; i < page->dirty_rect_count; i++) {
+      page->dirty_rects[0] =
+          atlas_rect_union(page->dirty_rects[0], page->dirty_rects[i]);
+    }
+    page->dirty_rects[0] = atlas_rect_union(page->dirty_rects[0], rect);
+    page->dirty_rect_count = 1;
+    return;
+  }
+
+  page->dirty_rects[page->dirty_rect_count++] = rect;
+}
+
+// 清空字形区域（含间距，回收的区域可能残留旧字形像素），返回需要上传的区域
+static AtlasPackerRect clear_atlas_rect(TextAtlasPage *page,
+                                        AtlasPackerRect rect) {
+  AtlasPackerRect clear_rect = {rect.x, rect.y,
+                                rect.width + ATLAS_PACKER_PADDING,
+                                rect.height + ATLAS_PACKER_PADDING};
+  if (clear_rect.x + clear_rect.width > TEXT_ATLAS_PAGE_SIZE)
+    clear_rect.width = TEXT_ATLAS_PAGE_SIZE - clear_rect.x;
+  if (clear_rect.y + clear_rect.height > TEXT_ATLAS_PAGE_SIZE)
+    clear_rect.height = TEXT_ATLAS_PAGE_SIZE - clear_rect.y;
+  for (int y = clear_rect.y; y < clear_rect.y + clear_rect.height; y++) {
+    memset(page->pixels + y * TEXT_ATLAS_PAGE_SIZE + clear_rect.x, 0,
+           clear_rect.width);
+  }
+  return clear_rect;
+}
+
+// 把字形像素写入图集第 layer 页中已分配的区域；tile 为后台光栅化的暂存块，
+// 为 NULL 时在渲染线程上直接光栅化到图集
+static void write_glyph_pixels(TextRenderer *renderer,
+                               const GlyphRasterJob *job, int layer,
+                               AtlasPackerRect rect,
+                               const unsigned char *tile) {
+  TextAtlasPage *page = renderer->atlas.pages[layer];
+  AtlasPackerRect clear_rect = clear_atlas_rect(page, rect);
+
+  unsigned char *atlas_origin =
+      page->pixels + rect.y * TEXT_ATLAS_PAGE_SIZE + rect.x;
+  if (tile) {
+    for (int y = 0; y < rect.height; y++) {
+      memcpy(atlas_origin + y * TEXT_ATLAS_PAGE_SIZE, tile + y * rect.width,
+             rect.width);
+    }
+  } else {
+    glyph_rasterizer_rasterize(job, atlas_origin, TEXT_ATLAS_PAGE_SIZE);
+  }
+
+  // 只标记新字形占用的区域
+  mark_atlas_dirty(&renderer->atlas, layer, clear_rect);
+  renderer->dynamic_generations++;
+}
+
+bool text_renderer_generate_glyph(TextRenderer *renderer, uint32_t glyph_index,
+                                  int font_id, int pixel_size) {
+  if (!renderer || font_id < 0 || font_id >= renderer->font_count)
+    return false;
+
+  TextFont *font = &renderer->fonts[font_id];
+  if (!font->loaded || !init_font_face(renderer, font))
+    return false;
+
+  bool sdf = pixel_size == TEXT_SDF_SIZE_KEY;
+  GlyphRasterJob job = {
+      .font_info = &font->font_info,
+      .glyph_index = glyph_index,
+      .scale = text_renderer_font_scale(font, sdf ? TEXT_SDF_BASE_SIZE
+                                                  : pixel_size),
+      .sdf = sdf,
+      .sdf_padding = TEXT_SDF_PADDING,
+      .sdf_on_edge = TEXT_SDF_ON_EDGE,
+      .font_id = font_id,
+      .pixel_size = pixel_size};
+
+  // 获取字符边界框（只计算度量，不光栅化）
   int x0, y0, x1, y1;
-  stbtt_GetCodepointBitmapBox(&font->font_info, codepoint, font->scale,
-                              font->scale, &x0, &y0, &x1, &y1);
+  stbtt_GetGlyphBitmapBox(&font->font_info, (int)glyph_index, job.scale,
+                          job.scale, &x0, &y0, &x1, &y1);
+  if (sdf && x1 > x0 && y1 > y0) {
+    // 距离场四周留出 TEXT_SDF_PADDING 像素，与 stbtt_GetGlyphSDF 一致
+    x0 -= TEXT_SDF_PADDING;
+    y0 -= TEXT_SDF_PADDING;
+    x1 += TEXT_SDF_PADDING;
+    y1 += TEXT_SDF_PADDING;
+  }
 
   int width = x1 - x0;
   int height = y1 - y0;
 
+  // 获取前进距离
+  int advance, lsb;
+  stbtt_GetGlyphHMetrics(&font->font_info, (int)glyph_index, &advance, &lsb);
+
   // 处理空白字符或无效字符
   if (width <= 0 || height <= 0) {
     TextGlyph glyph = {0};
-    glyph.codepoint = codepoint;
+    glyph.glyph_index = glyph_index;
     glyph.width = 0;
     glyph.height = 0;
     glyph.bearing_x = 0;
     glyph.bearing_y = 0;
+    glyph.advance = advance * job.scale;
     glyph.loaded = true;
 
-    // 获取前进距离
-    int advance, lsb;
-    stbtt_GetCodepointHMetrics(&font->font_info, codepoint, &advance, &lsb);
-    glyph.advance = advance * font->scale;
-
-    add_glyph_to_cache(renderer, codepoint, font_id, &glyph);
-    return true;
+    return add_glyph_to_cache(renderer, glyph_index, font_id, pixel_size,
+                              &glyph) != NULL;
   }
 
-  // 检查图集空间
-  if (renderer->atlas.current_x + width + 2 >= TEXT_ATLAS_WIDTH) {
-    renderer->atlas.current_x = 0;
-    renderer->atlas.current_y += renderer->atlas.line_height + 1;
-    renderer->atlas.line_height = 0;
-  }
-
-  if (renderer->atlas.current_y + height + 1 >= TEXT_ATLAS_HEIGHT) {
-    Log("字体图集空间不足，无法生成字形 U+%04X\n", codepoint);
+  // 分配图集空间
+  AtlasPackerRect atlas_rect;
+  int atlas_shelf, atlas_layer;
+  if (!alloc_atlas_rect(renderer, width, height, &atlas_rect, &atlas_shelf,
+                        &atlas_layer)) {
+    LOG_WARN("字体图集空间不足，无法生成字形 #%u\n", glyph_index);
     return false;
   }
 
-  // 生成字形位图
-  int atlas_x = renderer->atlas.current_x;
-  int atlas_y = renderer->atlas.current_y;
-
-  // 清空目标区域
-  for (int y = atlas_y; y < atlas_y + height; y++) {
-    for (int x = atlas_x; x < atlas_x + width; x++) {
-      renderer->atlas.pixels[y * TEXT_ATLAS_WIDTH + x] = 0;
-    }
-  }
-
-  // 生成位图到图集中
-  stbtt_MakeCodepointBitmap(
-      &font->font_info,
-      renderer->atlas.pixels + atlas_y * TEXT_ATLAS_WIDTH + atlas_x, width,
-      height, TEXT_ATLAS_WIDTH, font->scale, font->scale, codepoint);
+  int atlas_x = atlas_rect.x;
+  int atlas_y = atlas_rect.y;
 
   // 创建字形信息 - 使用准确的基线信息
   TextGlyph glyph = {0};
-  glyph.codepoint = codepoint;
+  glyph.glyph_index = glyph_index;
   glyph.width = width;
   glyph.height = height;
   glyph.bearing_x = x0;
   // bearing_y是从基线到字形顶部的距离（正值向上）
   // stb_truetype返回的y1是从基线到字形底部的距离（负值）
   glyph.bearing_y = -y1;
-  glyph.u0 = (float)atlas_x / TEXT_ATLAS_WIDTH;
-  glyph.v0 = (float)atlas_y / TEXT_ATLAS_HEIGHT;
-  glyph.u1 = (float)(atlas_x + width) / TEXT_ATLAS_WIDTH;
-  glyph.v1 = (float)(atlas_y + height) / TEXT_ATLAS_HEIGHT;
+  glyph.u0 = (float)atlas_x / TEXT_ATLAS_PAGE_SIZE;
+  glyph.v0 = (float)atlas_y / TEXT_ATLAS_PAGE_SIZE;
+  glyph.u1 = (float)(atlas_x + width) / TEXT_ATLAS_PAGE_SIZE;
+  glyph.v1 = (float)(atlas_y + height) / TEXT_ATLAS_PAGE_SIZE;
+  glyph.atlas_layer = (uint16_t)atlas_layer;
+  glyph.advance = advance * job.scale;
   glyph.loaded = true;
 
-  // 获取前进距离
-  int advance, lsb;
-  stbtt_GetCodepointHMetrics(&font->font_info, codepoint, &advance, &lsb);
-  glyph.advance = advance * font->scale;
+  // 添加到缓存并记录图集区域，淘汰时据此归还
+  TextGlyphCacheEntry *entry =
+      add_glyph_to_cache(renderer, glyph_index, font_id, pixel_size, &glyph);
+  if (!entry) {
+    // GPU字形表没有空闲槽位（本帧删除的槽位要到下一帧才能复用）
+    free_atlas_rect(renderer, atlas_layer, atlas_rect, atlas_shelf);
+    return false;
+  }
+  entry->atlas_rect = atlas_rect;
+  entry->atlas_shelf = atlas_shelf;
+
+  job.width = width;
+  job.height = height;
+
+  // 提交到后台光栅化：本帧只占位，结果在下一帧开始时写入图集
+  if (renderer->async_raster) {
+    job.job_id = ++renderer->next_raster_job;
+    if (job.job_id == 0)
+      job.job_id = ++renderer->next_raster_job; // 0 表示没有在途任务
+    if (glyph_rasterizer_submit(renderer->rasterizer, &job)) {
+      entry->glyph.pending = true;
+      entry->raster_job = job.job_id;
+      renderer->async_raster_jobs++;
+      return true;
+    }
+  }
 
-  // 添加到缓存
-  add_glyph_to_cache(renderer, codepoint, font_id, &glyph);
+  write_glyph_pixels(renderer, &job, atlas_layer, atlas_rect, NULL);
 
-  // 更新图集位置
-  renderer->atlas.current_x += width + 1; // 留1像素间距
-  if (height > renderer->atlas.line_height) {
-    renderer->atlas.line_height = height;
+  LOG_DEBUG("动态生成字形 #%u (字体 %d, %dpx) 到图集第 %d 页 (%d, %d), "
+            "尺寸 %dx%d, bearing(%.0f, %.0f), advance %.2f\n",
+            glyph_index, font_id, pixel_size, atlas_layer, atlas_x, atlas_y,
+            width, height,
+            glyph.bearing_x, glyph.bearing_y, glyph.advance);
+
+  return true;
+}
+
+// 把后台光栅化完成的字形写入图集，超出时间预算的留到下一帧
+// 期间被淘汰或重新生成的字形通过任务编号识别并丢弃
+static void commit_raster_results(TextRenderer *renderer) {
+  if (!renderer->rasterizer)
+    return;
+
+  double commit_start = GetTimeMs();
+  GlyphRasterResult result;
+  while (GetTimeMs() - commit_start < TEXT_RASTER_COMMIT_BUDGET_MS &&
+         glyph_rasterizer_poll(renderer->rasterizer, &result)) {
+    TextGlyphCacheEntry *entry = lookup_glyph_cache_entry(
+        renderer, result.job.glyph_index, result.job.font_id,
+        result.job.pixel_size);
+    if (entry && entry->glyph.pending &&
+        entry->raster_job == result.job.job_id) {
+      write_glyph_pixels(renderer, &result.job, entry->glyph.atlas_layer,
+                         entry->atlas_rect, result.pixels);
+      entry->glyph.pending = false;
+      entry->raster_job = 0;
+    }
+    free(result.pixels);
   }
+  renderer->raster_commit_ms += GetTimeMs() - commit_start;
+}
 
-  // 标记图集需要更新
-  renderer->atlas.dirty = true;
-  renderer->dynamic_generations++;
+void text_renderer_set_sdf_mode(TextRenderer *renderer, bool enabled) {
+  if (!renderer)
+    return;
+
+  // 两种模式的字形互不相同，已排版的文本段全部失效
+  if (renderer->sdf_mode != enabled)
+    renderer->atlas_generation++;
+  renderer->sdf_mode = enabled;
+  Log("文本SDF模式: %s\n", enabled ? "开启" : "关闭");
+}
+
+void text_renderer_set_async_raster(TextRenderer *renderer, bool enabled) {
+  if (!renderer)
+    return;
+
+  // 已提交的任务仍在下一帧开始时写入图集
+  renderer->async_raster = enabled && renderer->rasterizer != NULL;
+}
+
+// 持久化缓存文件头，其后依次为：page_count 页（每页为装箱器状态及其
+// next_shelf_y 行像素）、entry_count 个字形条目。结构体按原样写入，
+// 尺寸字段用于拒绝不兼容的文件
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t page_size;
+  uint32_t packer_size;
+  uint32_t entry_size;
+  uint32_t sdf_base_size;
+  uint32_t page_count;
+  uint32_t entry_count;
+  uint32_t font_count;
+  uint64_t font_hashes[TEXT_MAX_FONTS];
+} TextCacheHeader;
+
+static const char text_cache_magic[8] = "CLAYTXC";
+
+static void fill_cache_header(TextCacheHeader *header) {
+  memset(header, 0, sizeof(TextCacheHeader));
+  memcpy(header->magic, text_cache_magic, sizeof(header->magic));
+  header->version = TEXT_CACHE_VERSION;
+  header->page_size = TEXT_ATLAS_PAGE_SIZE;
+  header->packer_size = sizeof(AtlasPacker);
+  header->entry_size = sizeof(TextGlyphCacheEntry);
+  header->sdf_base_size = TEXT_SDF_BASE_SIZE;
+}
+
+// 用 from 原子替换 to：任何时刻磁盘上都有一份完整的缓存文件
+static bool replace_file(const char *from, const char *to) {
+#ifdef _WIN32
+  // Windows 下 rename 不覆盖已有文件；按 fopen 所用的代码页转换路径
+  wchar_t wide_from[512], wide_to[512];
+  if (!MultiByteToWideChar(CP_ACP, 0, from, -1, wide_from, 512) ||
+      !MultiByteToWideChar(CP_ACP, 0, to, -1, wide_to, 512))
+    return false;
+  return MoveFileExW(wide_from, wide_to,
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  return rename(from, to) == 0;
+#endif
+}
+
+bool text_renderer_save_cache(TextRenderer *renderer, const char *path) {
+  if (!renderer || !path)
+    return false;
+
+  TextCacheHeader header;
+  fill_cache_header(&header);
+  header.page_count = (uint32_t)renderer->atlas.page_count;
+  header.font_count = (uint32_t)renderer->font_count;
+  for (int i = 0; i < renderer->font_count; i++) {
+    header.font_hashes[i] = renderer->fonts[i].content_hash;
+  }
+  for (int i = 0; i < TEXT_GLYPH_CACHE_SIZE; i++) {
+    if (renderer->glyph_cache[i].occupied)
+      header.entry_count++;
+  }
+
+  // 先写临时文件，完整写入后再替换，避免中途退出留下半个缓存
+  char temp_path[512];
+  snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+  FILE *file = fopen(temp_path, "wb");
+  if (!file) {
+    LOG_WARN("无法写入字形缓存: %s\n", temp_path);
+    return false;
+  }
+
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  for (uint32_t i = 0; ok && i < header.page_count; i++) {
+    TextAtlasPage *page = renderer->atlas.pages[i];
+    size_t rows = (size_t)page->packer.next_shelf_y;
+    ok = fwrite(&page->packer, sizeof(AtlasPacker), 1, file) == 1 &&
+         (rows == 0 ||
+          fwrite(page->pixels, TEXT_ATLAS_PAGE_SIZE, rows, file) == rows);
+  }
+  for (int i = 0; ok && i < TEXT_GLYPH_CACHE_SIZE; i++) {
+    if (renderer->glyph_cache[i].occupied)
+      ok = fwrite(&renderer->glyph_cache[i], sizeof(TextGlyphCacheEntry), 1,
+                  file) == 1;
+  }
+  if (fclose(file) != 0)
+    ok = false;
+
+  if (ok)
+    ok = replace_file(temp_path, path);
+  if (!ok) {
+    remove(temp_path);
+    LOG_WARN("保存字形缓存失败: %s\n", path);
+    return false;
+  }
+
+  Log("字形缓存已保存: %s (%u 个字形, 图集 %u 页)\n", path,
+      header.entry_count, header.page_count);
+  return true;
+}
+
+// 文件中的 bool 按字节检查，非 0/1 的值不能以 bool 读取
+static bool is_bool_byte(const bool *value) {
+  unsigned char byte;
+  memcpy(&byte, value, 1);
+  return byte <= 1;
+}
+
+// 校验缓存条目的图集区域：必须位于所在页的某一行内，
+// 尺寸与纹理坐标与区域一致（与生成字形时的计算相同，可以精确比较）
+static bool cached_entry_matches_atlas(TextRenderer *renderer,
+                                       const TextGlyphCacheEntry *cached,
+                                       uint32_t page_count) {
+  const TextGlyph *glyph = &cached->glyph;
+  AtlasPackerRect rect = cached->atlas_rect;
+  if (glyph->atlas_layer >= page_count ||
+      !atlas_packer_contains(&renderer->atlas.pages[glyph->atlas_layer]->packer,
+                             rect, cached->atlas_shelf))
+    return false;
+
+  return glyph->width == (float)rect.width &&
+         glyph->height == (float)rect.height &&
+         glyph->u0 == (float)rect.x / TEXT_ATLAS_PAGE_SIZE &&
+         glyph->v0 == (float)rect.y / TEXT_ATLAS_PAGE_SIZE &&
+         glyph->u1 == (float)(rect.x + rect.width) / TEXT_ATLAS_PAGE_SIZE &&
+         glyph->v1 == (float)(rect.y + rect.height) / TEXT_ATLAS_PAGE_SIZE;
+}
+
+bool text_renderer_load_cache(TextRenderer *renderer, const char *path) {
+  if (!renderer || !path)
+    return false;
+
+  // 只能恢复到空图集，已有字形的区域会与缓存中的区域冲突
+  int allocated = 0;
+  for (int i = 0; i < renderer->atlas.page_count; i++) {
+    allocated += renderer->atlas.pages[i]->packer.allocated_count;
+  }
+  if (allocated > 0 || glyph_rasterizer_in_flight(renderer->rasterizer) > 0) {
+    LOG_WARN("字形缓存须在生成字形之前加载\n");
+    return false;
+  }
+
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    Log("没有字形缓存，冷启动: %s\n", path);
+    return false;
+  }
+
+  TextCacheHeader expected;
+  fill_cache_header(&expected);
+  TextCacheHeader header;
+  bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+            memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 &&
+            header.version == expected.version &&
+            header.page_size == expected.page_size &&
+            header.packer_size == expected.packer_size &&
+            header.entry_size == expected.entry_size &&
+            header.sdf_base_size == expected.sdf_base_size &&
+            header.page_count <= TEXT_ATLAS_MAX_PAGES &&
+            header.entry_count <= TEXT_GLYPH_CACHE_SIZE &&
+            header.font_count <= TEXT_MAX_FONTS;
+  if (!ok) {
+    fclose(file);
+    LOG_WARN("字形缓存版本或格式不匹配，忽略: %s\n", path);
+    return false;
+  }
+
+  // 缓存中的字体ID映射到当前字体ID，字体加载顺序变化时仍可复用
+  int font_map[TEXT_MAX_FONTS];
+  int matched_fonts = 0;
+  for (uint32_t i = 0; i < header.font_count; i++) {
+    font_map[i] = -1;
+    for (int j = 0; j < renderer->font_count; j++) {
+      if (renderer->fonts[j].loaded &&
+          renderer->fonts[j].content_hash == header.font_hashes[i]) {
+        font_map[i] = j;
+        matched_fonts++;
+        break;
+      }
+    }
+  }
+  if (matched_fonts == 0) {
+    fclose(file);
+    Log("字形缓存中的字体均未加载，忽略: %s\n", path);
+    return false;
+  }
 
-  Log("动态生成字形 U+%04X 到图集位置 (%d, %d), 尺寸 %dx%d, bearing(%.0f, "
-      "%.0f), advance %.2f\n",
-      codepoint, atlas_x, atlas_y, width, height, glyph.bearing_x,
-      glyph.bearing_y, glyph.advance);
+  // 图集像素直接读入各页的 CPU 端像素，不经过中间缓冲；页数不够时先加页
+  for (uint32_t i = 0; ok && i < header.page_count; i++) {
+    if ((int)i == renderer->atlas.page_count && !add_atlas_page(renderer)) {
+      ok = false;
+      break;
+    }
+    TextAtlasPage *page = renderer->atlas.pages[i];
+    AtlasPacker *packer = &page->packer;
+    ok = fread(packer, sizeof(AtlasPacker), 1, file) == 1 &&
+         packer->width == TEXT_ATLAS_PAGE_SIZE &&
+         packer->height == TEXT_ATLAS_PAGE_SIZE &&
+         atlas_packer_is_valid(packer);
+    size_t rows = ok ? (size_t)packer->next_shelf_y : 0;
+    if (ok && rows > 0)
+      ok = fread(page->pixels, TEXT_ATLAS_PAGE_SIZE, rows, file) == rows;
+  }
+
+  // 逐个重新插入：字体ID可能变化，哈希位置随之变化
+  int restored = 0;
+  for (uint32_t i = 0; ok && i < header.entry_count; i++) {
+    TextGlyphCacheEntry cached;
+    if (fread(&cached, sizeof(cached), 1, file) != 1 ||
+        !is_bool_byte(&cached.glyph.loaded) ||
+        !is_bool_byte(&cached.glyph.pending) ||
+        (cached.atlas_shelf >= 0 &&
+         !cached_entry_matches_atlas(renderer, &cached, header.page_count))) {
+      ok = false;
+      break;
+    }
+
+    int font_id = cached.font_id >= 0 && cached.font_id < (int)header.font_count
+                      ? font_map[cached.font_id]
+                      : -1;
+    if (font_id < 0 || cached.glyph.pending) {
+      // 字体未加载，或保存时仍在后台光栅化（没有像素）：归还图集空间
+      if (cached.atlas_shelf >= 0)
+        free_atlas_rect(renderer, cached.glyph.atlas_layer, cached.atlas_rect,
+                        cached.atlas_shelf);
+      continue;
+    }
+
+    TextGlyphCacheEntry *entry = add_glyph_to_cache(
+        renderer, cached.glyph_index, font_id, cached.pixel_size,
+        &cached.glyph);
+    if (!entry) {
+      if (cached.atlas_shelf >= 0)
+        free_atlas_rect(renderer, cached.glyph.atlas_layer, cached.atlas_rect,
+                        cached.atlas_shelf);
+      continue;
+    }
+    entry->atlas_rect = cached.atlas_rect;
+    entry->atlas_shelf = cached.atlas_shelf;
+    restored++;
+  }
+  fclose(file);
+
+  if (!ok) {
+    // 文件截断或损坏：恢复为空图集（已加的页保留，之后继续使用）
+    for (int i = 0; i < renderer->atlas.page_count; i++) {
+      atlas_packer_reset(&renderer->atlas.pages[i]->packer);
+    }
+    memset(renderer->glyph_cache, 0, sizeof(renderer->glyph_cache));
+    glyph_table_clear(&renderer->glyph_lookup);
+    reset_gpu_slots(renderer);
+    renderer->atlas_generation++;
+    LOG_WARN("字形缓存文件损坏，忽略: %s\n", path);
+    return false;
+  }
+
+  // 每页的已用区域作为一个脏区域，第一帧一次性上传
+  for (uint32_t i = 0; i < header.page_count; i++) {
+    int rows = renderer->atlas.pages[i]->packer.next_shelf_y;
+    if (rows > 0)
+      mark_atlas_dirty(&renderer->atlas, (int)i,
+                       (AtlasPackerRect){0, 0, TEXT_ATLAS_PAGE_SIZE, rows});
+  }
 
+  Log("字形缓存已加载: %s (%d 个字形, 图集 %u 页)\n", path, restored,
+      header.page_count);
   return true;
 }
 
@@ -722,256 +1855,556 @@ void text_renderer_flush_atlas(TextRenderer *renderer) {
   if (!renderer || !renderer->atlas.dirty)
     return;
 
-  WGPUTexelCopyTextureInfo dest = {.texture = renderer->atlas.texture,
-                                   .mipLevel = 0,
-                                   .origin = {0, 0, 0},
-                                   .aspect = WGPUTextureAspect_All};
+  // 逐页上传脏区域：源数据直接指向页像素中的子矩形，
+  // 行跨度为整页宽度，无需额外拷贝；目标层即页号
+  int rect_count = 0;
+  for (int layer = 0; layer < renderer->atlas.page_count; layer++) {
+    TextAtlasPage *page = renderer->atlas.pages[layer];
+    for (int i = 0; i < page->dirty_rect_count; i++) {
+      AtlasPackerRect rect = page->dirty_rects[i];
+
+      WGPUTexelCopyTextureInfo dest = {
+          .texture = renderer->atlas.texture,
+          .mipLevel = 0,
+          .origin = {(uint32_t)rect.x, (uint32_t)rect.y, (uint32_t)layer},
+          .aspect = WGPUTextureAspect_All};
+
+      WGPUTexelCopyBufferLayout layout = {
+          .offset = 0,
+          .bytesPerRow = TEXT_ATLAS_PAGE_SIZE,
+          .rowsPerImage = (uint32_t)rect.height};
+
+      WGPUExtent3D writeSize = {.width = (uint32_t)rect.width,
+                                .height = (uint32_t)rect.height,
+                                .depthOrArrayLayers = 1};
+
+      const unsigned char *source =
+          page->pixels + rect.y * TEXT_ATLAS_PAGE_SIZE + rect.x;
+      size_t source_size =
+          (size_t)(rect.height - 1) * TEXT_ATLAS_PAGE_SIZE + rect.width;
+
+      wgpuQueueWriteTexture(renderer->queue, &dest, source, source_size,
+                            &layout, &writeSize);
+      renderer->atlas_upload_bytes += (uint64_t)rect.width * rect.height;
+    }
+    rect_count += page->dirty_rect_count;
+    page->dirty_rect_count = 0;
+  }
 
-  WGPUTexelCopyBufferLayout layout = {.offset = 0,
-                                      .bytesPerRow = TEXT_ATLAS_WIDTH,
-                                      .rowsPerImage = TEXT_ATLAS_HEIGHT};
+  LOG_DEBUG("更新字体图集纹理：%d 个区域\n", rect_count);
 
-  WGPUExtent3D writeSize = {.width = TEXT_ATLAS_WIDTH,
-                            .height = TEXT_ATLAS_HEIGHT,
-                            .depthOrArrayLayers = 1};
+  renderer->atlas.dirty = false;
+}
 
-  wgpuQueueWriteTexture(renderer->queue, &dest, renderer->atlas.pixels,
-                        TEXT_ATLAS_WIDTH * TEXT_ATLAS_HEIGHT, &layout,
-                        &writeSize);
+// 字符串内容哈希（字符串宽度与文本段缓存共用），0 保留给空条目
+static uint64_t hash_text(const char *text, int length) {
+  uint64_t hash = hash_bytes(0x9E3779B97F4A7C15ull ^ (uint64_t)length,
+                             (const unsigned char *)text, (size_t)length);
+  return hash | 1;
+}
 
-  Log("更新字体图集纹理 (当前位置: %d, %d)\n", renderer->atlas.current_x,
-      renderer->atlas.current_y);
+// 字符串宽度缓存：组相联，命中时刷新使用帧，未命中时替换组内最久未用的条目
+static TextMeasureEntry *measure_cache_set(TextRenderer *renderer,
+                                           uint64_t hash, int font_id,
+                                           int font_size) {
+  uint64_t key = hash ^ ((uint64_t)font_id << 48) ^ ((uint64_t)font_size << 32);
+  key ^= key >> 29;
+  uint32_t set_count = TEXT_MEASURE_CACHE_SIZE / TEXT_MEASURE_CACHE_WAYS;
+  return &renderer->measure_cache[(uint32_t)key % set_count *
+                                  TEXT_MEASURE_CACHE_WAYS];
+}
 
-  renderer->atlas.dirty = false;
+// 一段已解码码点的总宽度；prev_font/prev_glyph 跨段传递以计算段边界处的字距
+static float measure_codepoints(TextRenderer *renderer,
+                                const uint32_t *codepoints, int count,
+                                int font_id, int font_size, float scale,
+                                int *prev_font, uint32_t *prev_glyph) {
+  float width = 0.0f;
+  for (int i = 0; i < count; i++) {
+    int glyph_font;
+    uint32_t glyph_index;
+    float advance = glyph_metrics_advance(renderer, codepoints[i], font_id,
+                                          font_size, scale, &glyph_font,
+                                          &glyph_index);
+    width += kerning_adjustment(renderer, *prev_font, *prev_glyph, glyph_font,
+                                glyph_index, font_size);
+    width += advance;
+    *prev_font = glyph_font;
+    *prev_glyph = glyph_index;
+  }
+  return width;
+}
+
+static float measure_run(TextRenderer *renderer, const char *text, int length,
+                         int font_id, int font_size) {
+  float scale = text_renderer_font_scale(&renderer->fonts[font_id], font_size);
+  uint32_t codepoints[TEXT_DECODE_CHUNK];
+  float width = 0.0f;
+  int pos = 0;
+  int prev_font = -1;
+  uint32_t prev_glyph = 0;
+
+  while (pos < length) {
+    int consumed;
+    int count = utf8_decode_run(text + pos, length - pos, codepoints,
+                                TEXT_DECODE_CHUNK, &consumed);
+    width += measure_codepoints(renderer, codepoints, count, font_id,
+                                font_size, scale, &prev_font, &prev_glyph);
+    pos += consumed;
+    if (count < TEXT_DECODE_CHUNK)
+      break; // 到达末尾或遇到NUL
+  }
+
+  return width;
 }
 
 float text_renderer_measure_string_width(TextRenderer *renderer,
                                          const char *text, int font_id,
-                                         int max_chars) {
+                                         int font_size, int text_length) {
   if (!renderer || !text)
     return 0.0f;
 
-  if (font_id < 0)
-    font_id = renderer->default_font_id;
-  if (font_id < 0 || font_id >= renderer->font_count)
+  if (!resolve_font(renderer, &font_id, &font_size))
     return 0.0f;
 
-  float width = 0.0f;
-  const char *ptr = text;
-  int char_count = 0;
-
-  while (*ptr && (max_chars <= 0 || char_count < max_chars)) {
-    UTF8Result result = text_decode_utf8(&ptr);
-    if (!result.valid)
-      break;
+  int length = text_length > 0 ? text_length : (int)strlen(text);
+  if (length == 0)
+    return 0.0f;
 
-    TextGlyph *glyph =
-        text_renderer_get_glyph(renderer, result.codepoint, font_id);
-    if (glyph) {
-      width += glyph->advance;
+  uint64_t hash = hash_text(text, length);
+  TextMeasureEntry *set = measure_cache_set(renderer, hash, font_id, font_size);
+  TextMeasureEntry *victim = &set[0];
+  for (int i = 0; i < TEXT_MEASURE_CACHE_WAYS; i++) {
+    TextMeasureEntry *entry = &set[i];
+    if (entry->hash == hash && entry->length == length &&
+        entry->font_id == font_id && entry->font_size == font_size) {
+      entry->last_used_frame = renderer->frame_index;
+      renderer->measure_hits++;
+      return entry->width;
     }
-
-    char_count++;
+    if (entry->hash == 0 ||
+        (victim->hash != 0 &&
+         entry->last_used_frame < victim->last_used_frame))
+      victim = entry;
   }
 
+  renderer->measure_misses++;
+  float width = measure_run(renderer, text, length, font_id, font_size);
+  *victim = (TextMeasureEntry){hash, length, font_id, font_size, width,
+                               renderer->frame_index};
   return width;
 }
 
-float text_renderer_get_line_height(TextRenderer *renderer, int font_id) {
+float text_renderer_get_line_height(TextRenderer *renderer, int font_id,
+                                    int font_size) {
   if (!renderer)
     return 0.0f;
 
-  if (font_id < 0)
-    font_id = renderer->default_font_id;
-  if (font_id < 0 || font_id >= renderer->font_count)
+  TextFont *font = resolve_font(renderer, &font_id, &font_size);
+  if (!font)
     return 0.0f;
 
-  return renderer->fonts[font_id].line_height;
+  return (font->ascent - font->descent + font->line_gap) *
+         text_renderer_font_scale(font, font_size);
 }
 
 void text_renderer_begin_frame(TextRenderer *renderer) {
   if (!renderer)
     return;
 
+  renderer->frame_index++;
+
   // 重置批次
-  renderer->current_batch.vertex_count = 0;
-  renderer->current_batch.index_count = 0;
-  renderer->current_batch.char_count = 0;
+  reset_batch(&renderer->current_batch);
   renderer->current_batch.font_id = -1;
 
+  // 上一帧删除的字形已不再被任何批次引用，槽位可以复用
+  while (renderer->gpu_retired_count > 0) {
+    renderer->gpu_free_slots[renderer->gpu_free_count++] =
+        renderer->gpu_retired_slots[--renderer->gpu_retired_count];
+  }
+
+  // 定期释放长时间未绘制的文本段
+  if (renderer->frame_index % 64 == 0)
+    evict_text_runs(renderer);
+
+  gpu_ring_begin_frame(&renderer->geometry_ring);
+
+  // 写入上一帧之后完成的后台光栅化结果
+  commit_raster_results(renderer);
+
   // 如果图集需要更新，现在更新
   if (renderer->atlas.dirty) {
     text_renderer_flush_atlas(renderer);
   }
 }
 
-void text_renderer_flush_batch(TextRenderer *renderer,
-                               WGPURenderPassEncoder render_pass) {
-  if (!renderer || !render_pass || renderer->current_batch.char_count == 0)
-    return;
-
-  Log("刷新文本批次：%d 个字符，%d 个顶点，%d 个索引\n",
-      renderer->current_batch.char_count, renderer->current_batch.vertex_count,
-      renderer->current_batch.index_count);
+bool text_renderer_upload_batch(TextRenderer *renderer) {
+  if (!renderer || renderer->current_batch.char_count == 0)
+    return false;
 
   // 刷新图集纹理（如果有更新）
   text_renderer_flush_atlas(renderer);
 
-  // 上传顶点和索引数据
-  size_t vertex_data_size =
-      renderer->current_batch.vertex_count * 8 * sizeof(float);
-  size_t index_data_size =
-      renderer->current_batch.index_count * sizeof(uint16_t);
+  // 只上传本帧新增或更新的字形表槽位
+  if (renderer->gpu_dirty_min <= renderer->gpu_dirty_max) {
+    wgpuQueueWriteBuffer(
+        renderer->queue, renderer->glyph_table_buffer,
+        renderer->gpu_dirty_min * sizeof(TextGpuGlyph),
+        &renderer->gpu_glyphs[renderer->gpu_dirty_min],
+        (renderer->gpu_dirty_max - renderer->gpu_dirty_min + 1) *
+            sizeof(TextGpuGlyph));
+    renderer->gpu_dirty_min = TEXT_GLYPH_CACHE_SIZE;
+    renderer->gpu_dirty_max = -1;
+  }
+
+  // 封存最后一段（写满的段在写入过程中已经上传）
+  return seal_batch_segment(renderer) &&
+         renderer->current_batch.segment_count > 0;
+}
 
-  wgpuQueueWriteBuffer(renderer->queue, renderer->vertex_buffer, 0,
-                       renderer->current_batch.vertex_data, vertex_data_size);
-  wgpuQueueWriteBuffer(renderer->queue, renderer->index_buffer, 0,
-                       renderer->current_batch.index_data, index_data_size);
+void text_renderer_bind_batch(TextRenderer *renderer,
+                              WGPURenderPassEncoder render_pass) {
+  if (!renderer || !render_pass)
+    return;
 
   // 设置渲染状态
-  wgpuRenderPassEncoderSetPipeline(render_pass, renderer->text_pipeline);
+  wgpuRenderPassEncoderSetPipeline(render_pass, renderer->sdf_mode
+                                                     ? renderer->sdf_pipeline
+                                                     : renderer->text_pipeline);
   wgpuRenderPassEncoderSetBindGroup(render_pass, 0, renderer->atlas.bind_group,
                                     0, NULL);
 
-  // 设置缓冲区
-  wgpuRenderPassEncoderSetVertexBuffer(render_pass, 0, renderer->vertex_buffer,
-                                       0, vertex_data_size);
-  wgpuRenderPassEncoderSetIndexBuffer(render_pass, renderer->index_buffer,
-                                      WGPUIndexFormat_Uint16, 0,
-                                      index_data_size);
+  // 实例缓冲区按段在绘制时绑定
+  renderer->bound_segment = -1;
+}
+
+void text_renderer_draw_range(TextRenderer *renderer,
+                              WGPURenderPassEncoder render_pass,
+                              uint32_t first, uint32_t count) {
+  if (!renderer || !render_pass || count == 0)
+    return;
+
+  // 区间按序绘制，从当前绑定的段开始向后查找
+  TextRenderBatch *batch = &renderer->current_batch;
+  int index = renderer->bound_segment;
+  if (index < 0 || index >= batch->segment_count ||
+      (uint32_t)batch->segments[index].first > first)
+    index = 0;
+
+  uint32_t end = first + count;
+  for (; index < batch->segment_count && first < end; index++) {
+    const TextBatchSegment *segment = &batch->segments[index];
+    uint32_t segment_end = (uint32_t)(segment->first + segment->count);
+    if (segment_end <= first)
+      continue;
+
+    if (renderer->bound_segment != index) {
+      wgpuRenderPassEncoderSetVertexBuffer(render_pass, 0,
+                                           segment->alloc.buffer,
+                                           segment->alloc.offset,
+                                           segment->alloc.size);
+      renderer->bound_segment = index;
+    }
 
-  // 绘制
-  wgpuRenderPassEncoderDrawIndexed(
-      render_pass, renderer->current_batch.index_count, 1, 0, 0, 0);
+    uint32_t draw_end = end < segment_end ? end : segment_end;
+    wgpuRenderPassEncoderDraw(render_pass, 6, draw_end - first, 0,
+                              first - (uint32_t)segment->first);
+    first = draw_end;
+  }
+}
+
+void text_renderer_flush_batch(TextRenderer *renderer,
+                               WGPURenderPassEncoder render_pass) {
+  if (!renderer || !render_pass || renderer->current_batch.char_count == 0)
+    return;
+
+  LOG_DEBUG("刷新文本批次：%d 个字符\n", renderer->current_batch.char_count);
+
+  if (text_renderer_upload_batch(renderer)) {
+    text_renderer_bind_batch(renderer, render_pass);
+
+    // 绘制：每个实例6个顶点
+    text_renderer_draw_range(renderer, render_pass, 0,
+                             (uint32_t)renderer->current_batch.char_count);
+  }
 
   // 重置批次
-  renderer->current_batch.vertex_count = 0;
-  renderer->current_batch.index_count = 0;
-  renderer->current_batch.char_count = 0;
+  reset_batch(&renderer->current_batch);
+}
+
+// 计算字形在笔位置 (pen_x, pen_y) 处的四边形，不可见（空白或未就绪）时返回 false
+static bool make_run_glyph(TextRenderer *renderer, const TextGlyph *glyph,
+                           uint32_t codepoint, float pen_x, float pen_y,
+                           int font_size, TextRunGlyph *out) {
+  if (!glyph->loaded || glyph->pending)
+    return false;
+
+  // 跳过空白字符的渲染
+  if (glyph->width <= 0 || glyph->height <= 0)
+    return false;
+
+  // 调试：输出异常字符信息
+  if (fabsf(glyph->bearing_y) > glyph->height * 0.5f) {
+    LOG_TRACE("警告：字符 U+%04X 的bearing_y值异常: bearing_y=%.1f, height=%.1f\n",
+              codepoint, glyph->bearing_y, glyph->height);
+  }
+
+  // 分桶后的栅格化字号与请求字号不同时，按比例缩放四边形
+  float size_ratio = glyph_size_ratio(renderer, font_size);
+  float glyph_width = glyph->width * size_ratio;
+  float glyph_height = glyph->height * size_ratio;
+
+  // 使用字形基线对齐：从基线开始计算字形顶部
+  out->x1 = pen_x + glyph->bearing_x * size_ratio;
+  out->y1 = pen_y - glyph->bearing_y * size_ratio - glyph_height;
+  out->x2 = out->x1 + glyph_width;
+  out->y2 = out->y1 + glyph_height;
+  out->pen_x = pen_x;
+  out->pen_y = pen_y;
+  out->glyph = (uint32_t)glyph->gpu_slot | (uint32_t)font_size << 16;
+  return true;
+}
+
+static uint8_t pack_unorm8(float value) {
+  if (value <= 0.0f)
+    return 0;
+  if (value >= 255.0f)
+    return 255;
+  return (uint8_t)(value + 0.5f);
+}
+
+// 把文本段的字形平移到 (x, y) 并作为实例写入批次
+static void emit_run_glyphs(TextRenderer *renderer, const TextRunGlyph *glyphs,
+                            int count, float x, float y, Clay_Color color) {
+  TextRenderBatch *batch = &renderer->current_batch;
+  uint8_t packed[4] = {pack_unorm8(color.r), pack_unorm8(color.g),
+                       pack_unorm8(color.b), pack_unorm8(color.a)};
+  float screen_width = (float)renderer->screen_width;
+  float screen_height = (float)renderer->screen_height;
+
+  for (int i = 0; i < count; i++) {
+    const TextRunGlyph *quad = &glyphs[i];
+    float x1 = x + quad->x1, y1 = y + quad->y1;
+    float x2 = x + quad->x2, y2 = y + quad->y2;
+
+    // 完全位于裁剪区域之外的字形直接剔除
+    if (renderer->clip_enabled &&
+        (x2 <= renderer->clip_rect.x ||
+         x1 >= renderer->clip_rect.x + renderer->clip_rect.width ||
+         y2 <= renderer->clip_rect.y ||
+         y1 >= renderer->clip_rect.y + renderer->clip_rect.height)) {
+      continue;
+    }
+
+    // 确保坐标在合理范围内（与原NDC [-2, 2] 的检查等价）
+    if (x1 < -0.5f * screen_width || x1 > 1.5f * screen_width ||
+        y1 < -0.5f * screen_height || y1 > 1.5f * screen_height) {
+      LOG_TRACE("警告：字符坐标超出范围 (%.2f, %.2f)\n", x1, y1);
+      continue;
+    }
+
+    // 检查批次容量（不足时扩容，当前段写满时封存并开始新段）
+    if (!reserve_batch(renderer)) {
+      LOG_WARN("警告：批次扩容失败，无法添加更多字符\n");
+      return;
+    }
+
+    TextGlyphInstance *instance =
+        &batch->instances[batch->char_count++ - batch->segment_first];
+    instance->pen_x = x + quad->pen_x;
+    instance->pen_y = y + quad->pen_y;
+    instance->glyph = quad->glyph;
+    memcpy(instance->color, packed, sizeof(packed));
+
+    LOG_TRACE("添加字符到批次: 屏幕(%.1f,%.1f-%.1f,%.1f) 槽位 %u\n", x1, y1,
+              x2, y2, quad->glyph & 0xFFFF);
+  }
 }
 
 void text_renderer_add_char_to_batch(TextRenderer *renderer, uint32_t codepoint,
                                      float x, float y, int font_id,
-                                     Clay_Color color) {
+                                     int font_size, Clay_Color color) {
   if (!renderer)
     return;
 
-  // 检查是否需要刷新批次
-  if (renderer->current_batch.char_count >= TEXT_MAX_CHARS_PER_BATCH) {
-    Log("警告：批次已满，无法添加更多字符\n");
+  TextGlyph *glyph =
+      text_renderer_get_glyph(renderer, codepoint, font_id, font_size);
+  if (!glyph)
     return;
-  }
 
-  TextGlyph *glyph = text_renderer_get_glyph(renderer, codepoint, font_id);
-  if (!glyph || !glyph->loaded)
+  if (!resolve_font(renderer, &font_id, &font_size))
     return;
 
-  // 跳过空白字符的渲染
-  if (glyph->width <= 0 || glyph->height <= 0)
-    return;
+  TextRunGlyph quad;
+  if (make_run_glyph(renderer, glyph, codepoint, 0.0f, 0.0f, font_size, &quad))
+    emit_run_glyphs(renderer, &quad, 1, x, y, color);
+}
 
-  // 计算屏幕坐标 - 使用字形基线对齐
-  float x1 = x + glyph->bearing_x;
-  float y1 = y - glyph->bearing_y - glyph->height; // 从基线开始计算字形顶部
-  float x2 = x1 + glyph->width;
-  float y2 = y1 + glyph->height;
+static bool reserve_run_scratch(TextRenderer *renderer, int count) {
+  if (count <= renderer->run_scratch_capacity)
+    return true;
 
-  // 调试：输出异常字符信息
-  if (fabsf(glyph->bearing_y) > glyph->height * 0.5f) {
-    Log("警告：字符 U+%04X 的bearing_y值异常: bearing_y=%.1f, height=%.1f\n",
-        codepoint, glyph->bearing_y, glyph->height);
+  int capacity = renderer->run_scratch_capacity ? renderer->run_scratch_capacity
+                                                : TEXT_DECODE_CHUNK;
+  while (capacity < count)
+    capacity *= 2;
+  TextRunGlyph *glyphs =
+      realloc(renderer->run_scratch, capacity * sizeof(TextRunGlyph));
+  if (!glyphs)
+    return false;
+  renderer->run_scratch = glyphs;
+  renderer->run_scratch_capacity = capacity;
+  return true;
+}
+
+// 排版一段文本：把可见字形相对于起点的四边形写入暂存区，返回字形数；
+// 有字形尚在后台光栅化时 *complete 为 false，结果不进入缓存
+static int layout_text_run(TextRenderer *renderer, const char *text,
+                           int length, int font_id, int font_size,
+                           bool *complete) {
+  uint32_t codepoints[TEXT_DECODE_CHUNK];
+  int pos = 0;
+  int glyph_count = 0;
+  float cursor_x = 0.0f;
+  float cursor_y = 0.0f;
+  *complete = true;
+
+  // 计算字体基线信息，确保换行时保持一致的基线间距
+  float baseline_spacing =
+      text_renderer_get_line_height(renderer, font_id, font_size);
+  float scale = text_renderer_font_scale(&renderer->fonts[font_id], font_size);
+  int prev_font = -1;
+  uint32_t prev_glyph = 0;
+
+  while (pos < length) {
+    int consumed;
+    int count = utf8_decode_run(text + pos, length - pos, codepoints,
+                                TEXT_DECODE_CHUNK, &consumed);
+
+    for (int i = 0; i < count; i++) {
+      uint32_t codepoint = codepoints[i];
+      if (codepoint == '\n') {
+        cursor_x = 0.0f;
+        cursor_y += baseline_spacing; // 使用一致的基线间距
+        prev_font = -1;
+        continue;
+      }
+
+      // 前进宽度与字距和测量时的计算方式相同，Clay 的布局与绘制保持一致
+      int glyph_font;
+      uint32_t glyph_index;
+      float advance =
+          glyph_metrics_advance(renderer, codepoint, font_id, font_size, scale,
+                                &glyph_font, &glyph_index);
+      cursor_x += kerning_adjustment(renderer, prev_font, prev_glyph,
+                                     glyph_font, glyph_index, font_size);
+      prev_font = glyph_font;
+      prev_glyph = glyph_index;
+
+      TextGlyph *glyph = find_or_generate_codepoint_glyph(
+          renderer, font_id, codepoint, glyph_font, glyph_index, font_size);
+      if (!glyph) {
+        *complete = false;
+      } else if (glyph->pending) {
+        *complete = false;
+      } else if (reserve_run_scratch(renderer, glyph_count + 1) &&
+                 make_run_glyph(renderer, glyph, codepoint, cursor_x, cursor_y,
+                                font_size,
+                                &renderer->run_scratch[glyph_count])) {
+        glyph_count++;
+      }
+      cursor_x += advance;
+    }
+
+    pos += consumed;
+    if (count < TEXT_DECODE_CHUNK)
+      break; // 到达末尾或遇到NUL
   }
 
-  // 转换为NDC坐标
-  float ndc_x1 = (x1 / (float)renderer->screen_width) * 2.0f - 1.0f;
-  float ndc_y1 = 1.0f - (y1 / (float)renderer->screen_height) * 2.0f;
-  float ndc_x2 = (x2 / (float)renderer->screen_width) * 2.0f - 1.0f;
-  float ndc_y2 = 1.0f - (y2 / (float)renderer->screen_height) * 2.0f;
+  return glyph_count;
+}
 
-  // 确保坐标在合理范围内
-  if (ndc_x1 < -2.0f || ndc_x1 > 2.0f || ndc_y1 < -2.0f || ndc_y1 > 2.0f) {
-    Log("警告：字符坐标超出范围 U+%04X at (%.2f, %.2f) -> NDC(%.2f, %.2f)\n",
-        codepoint, x1, y1, ndc_x1, ndc_y1);
-    return;
+// 文本段缓存的组（与字符串宽度缓存相同的组相联结构）
+static TextRun *text_run_set(TextRenderer *renderer, uint64_t hash,
+                             int font_id, int font_size) {
+  uint64_t key = hash ^ ((uint64_t)font_id << 48) ^ ((uint64_t)font_size << 32);
+  key ^= key >> 29;
+  uint32_t set_count = TEXT_RUN_CACHE_SIZE / TEXT_RUN_CACHE_WAYS;
+  return &renderer->run_cache[(uint32_t)key % set_count * TEXT_RUN_CACHE_WAYS];
+}
+
+// 刷新文本段中字形的LRU时间：经由缓存绘制的字形同样算作本帧使用，
+// 否则本帧内的淘汰会回收已写入批次的字形的槽位与图集区域
+static void touch_run_glyphs(TextRenderer *renderer, const TextRun *run) {
+  for (int i = 0; i < run->glyph_count; i++) {
+    renderer->glyph_cache[run->glyphs[i].glyph & 0xFFFF].last_used_frame =
+        renderer->frame_index;
   }
+}
 
-  // 添加顶点数据（包含颜色）
-  int base_vertex = renderer->current_batch.vertex_count;
-  float *vertices = renderer->current_batch.vertex_data + base_vertex * 8;
-
-  // 左上
-  vertices[0] = ndc_x1;
-  vertices[1] = ndc_y1;
-  vertices[2] = glyph->u0;
-  vertices[3] = glyph->v0;
-  vertices[4] = color.r / 255.0f;
-  vertices[5] = color.g / 255.0f;
-  vertices[6] = color.b / 255.0f;
-  vertices[7] = color.a / 255.0f;
-  vertices += 8;
-  // 右上
-  vertices[0] = ndc_x2;
-  vertices[1] = ndc_y1;
-  vertices[2] = glyph->u1;
-  vertices[3] = glyph->v0;
-  vertices[4] = color.r / 255.0f;
-  vertices[5] = color.g / 255.0f;
-  vertices[6] = color.b / 255.0f;
-  vertices[7] = color.a / 255.0f;
-  vertices += 8;
-  // 左下
-  vertices[0] = ndc_x1;
-  vertices[1] = ndc_y2;
-  vertices[2] = glyph->u0;
-  vertices[3] = glyph->v1;
-  vertices[4] = color.r / 255.0f;
-  vertices[5] = color.g / 255.0f;
-  vertices[6] = color.b / 255.0f;
-  vertices[7] = color.a / 255.0f;
-  vertices += 8;
-  // 右下
-  vertices[0] = ndc_x2;
-  vertices[1] = ndc_y2;
-  vertices[2] = glyph->u1;
-  vertices[3] = glyph->v1;
-  vertices[4] = color.r / 255.0f;
-  vertices[5] = color.g / 255.0f;
-  vertices[6] = color.b / 255.0f;
-  vertices[7] = color.a / 255.0f;
-
-  // 添加索引数据
-  int base_index = renderer->current_batch.index_count;
-  uint16_t *indices = renderer->current_batch.index_data + base_index;
-
-  uint16_t vertex_offset = renderer->current_batch.vertex_count;
-  indices[0] = vertex_offset + 0; // 左上
-  indices[1] = vertex_offset + 1; // 右上
-  indices[2] = vertex_offset + 2; // 左下
-  indices[3] = vertex_offset + 1; // 右上
-  indices[4] = vertex_offset + 3; // 右下
-  indices[5] = vertex_offset + 2; // 左下
-
-  renderer->current_batch.vertex_count += 4;
-  renderer->current_batch.index_count += 6;
-  renderer->current_batch.char_count++;
-
-  // 调试输出
-  Log("添加字符 U+%04X 到批次: 屏幕(%.1f,%.1f-%.1f,%.1f) "
-      "NDC(%.3f,%.3f-%.3f,%.3f) UV(%.3f,%.3f-%.3f,%.3f)\n",
-      codepoint, x1, y1, x2, y2, ndc_x1, ndc_y1, ndc_x2, ndc_y2, glyph->u0,
-      glyph->v0, glyph->u1, glyph->v1);
+// 查找可直接复用的文本段；未命中时 *slot 返回用于保存新排版结果的条目
+// （键相同但已失效的条目，或组内最久未用的条目）
+static TextRun *find_text_run(TextRenderer *renderer, uint64_t hash,
+                              int length, int font_id, int font_size,
+                              TextRun **slot) {
+  TextRun *set = text_run_set(renderer, hash, font_id, font_size);
+  TextRun *victim = &set[0];
+  for (int i = 0; i < TEXT_RUN_CACHE_WAYS; i++) {
+    TextRun *run = &set[i];
+    if (run->hash == hash && run->length == length &&
+        run->font_id == font_id && run->font_size == font_size) {
+      // 字形被淘汰后槽位可能已复用，需要重新排版
+      if (run->atlas_generation == renderer->atlas_generation) {
+        run->last_used_frame = renderer->frame_index;
+        touch_run_glyphs(renderer, run);
+        return run;
+      }
+      *slot = run;
+      return NULL;
+    }
+    if (run->hash == 0 ||
+        (victim->hash != 0 && run->last_used_frame < victim->last_used_frame))
+      victim = run;
+  }
+  *slot = victim;
+  return NULL;
+}
+
+static void store_text_run(TextRenderer *renderer, TextRun *run, uint64_t hash,
+                           int length, int font_id, int font_size,
+                           int glyph_count) {
+  if (glyph_count > run->glyph_capacity) {
+    TextRunGlyph *glyphs =
+        realloc(run->glyphs, glyph_count * sizeof(TextRunGlyph));
+    if (!glyphs)
+      return;
+    run->glyphs = glyphs;
+    run->glyph_capacity = glyph_count;
+  }
+  if (glyph_count > 0)
+    memcpy(run->glyphs, renderer->run_scratch,
+           glyph_count * sizeof(TextRunGlyph));
+
+  run->hash = hash;
+  run->length = length;
+  run->font_id = font_id;
+  run->font_size = font_size;
+  run->glyph_count = glyph_count;
+  run->atlas_generation = renderer->atlas_generation;
+  run->last_used_frame = renderer->frame_index;
 }
 
 void text_renderer_render_string(TextRenderer *renderer,
                                  WGPURenderPassEncoder render_pass,
                                  const char *text, int text_length, float x,
-                                 float y, Clay_Color color, int font_id) {
+                                 float y, Clay_Color color, int font_id,
+                                 int font_size) {
   if (!renderer || !text)
     return;
 
-  if (font_id < 0)
-    font_id = renderer->default_font_id;
-  if (font_id < 0 || font_id >= renderer->font_count)
+  TextFont *font = resolve_font(renderer, &font_id, &font_size);
+  if (!font)
     return;
 
   // 只有在有render_pass时才检查是否需要刷新批次
@@ -988,37 +2421,29 @@ void text_renderer_render_string(TextRenderer *renderer,
   // 设置当前批次参数
   renderer->current_batch.font_id = font_id;
 
-  // 渲染字符串
-  const char *ptr = text;
-  const char *end = text + (text_length > 0 ? text_length : strlen(text));
-  float cursor_x = x;
-  float cursor_y = y;
-
-  // 计算字体基线信息，确保换行时保持一致的基线间距
-  TextFont *font = text_renderer_get_font(renderer, font_id);
-  float baseline_spacing =
-      (font && font->loaded) ? font->line_height
-                             : text_renderer_get_line_height(renderer, font_id);
-
-  while (ptr < end && *ptr) {
-    UTF8Result result = text_decode_utf8(&ptr);
-    if (!result.valid)
-      break;
-
-    if (result.codepoint == '\n') {
-      cursor_x = x;
-      cursor_y += baseline_spacing; // 使用一致的基线间距
-      continue;
-    }
+  int length = text_length > 0 ? text_length : (int)strlen(text);
+  if (length == 0)
+    return;
 
-    TextGlyph *glyph =
-        text_renderer_get_glyph(renderer, result.codepoint, font_id);
-    if (glyph) {
-      text_renderer_add_char_to_batch(renderer, result.codepoint, cursor_x,
-                                      cursor_y, font_id, color);
-      cursor_x += glyph->advance;
-    }
+  // 未变化的文本段直接复用上次排版的四边形，只需平移并写入批次
+  uint64_t hash = hash_text(text, length);
+  TextRun *slot = NULL;
+  TextRun *run =
+      find_text_run(renderer, hash, length, font_id, font_size, &slot);
+  if (run) {
+    renderer->run_hits++;
+    emit_run_glyphs(renderer, run->glyphs, run->glyph_count, x, y, color);
+    return;
   }
+
+  renderer->run_misses++;
+  bool complete;
+  int glyph_count =
+      layout_text_run(renderer, text, length, font_id, font_size, &complete);
+  if (complete)
+    store_text_run(renderer, slot, hash, length, font_id, font_size,
+                   glyph_count);
+  emit_run_glyphs(renderer, renderer->run_scratch, glyph_count, x, y, color);
 }
 
 void text_renderer_render_clay_text(TextRenderer *renderer,
@@ -1028,39 +2453,46 @@ void text_renderer_render_clay_text(TextRenderer *renderer,
   if (!renderer || !text_data)
     return;
 
-  // 使用准确的字体度量信息计算基线
-  TextFont *font = text_renderer_get_font(renderer, renderer->default_font_id);
+  // 使用Clay指定的字体和字号，与测量时保持一致
+  int font_id = text_data->fontId;
+  int font_size = text_data->fontSize;
+  TextFont *font = resolve_font(renderer, &font_id, &font_size);
   if (!font || !font->loaded)
     return;
 
   // 计算垂直居中的基线位置
   // 使用字体基线作为参考，让字形自然对齐
-  float ascent = font->ascent * font->scale;
-  float descent = font->descent * font->scale;
+  float scale = text_renderer_font_scale(font, font_size);
+  float ascent = font->ascent * scale;
+  float descent = font->descent * scale;
   float font_height = ascent - descent;
 
   // 使用字体基线作为参考，字形会自然对齐到基线
   float baseline_y = bbox.y + bbox.height - (bbox.height - font_height) / 2.0f;
 
-  //   Log("渲染Clay文本: \"%.*s\" 在位置 (%.1f, %.1f), 字体大小 %d, 基线
-  //   %.1f\n",
-  //          (int)text_data->stringContents.length,
-  //          text_data->stringContents.chars, bbox.x, baseline_y,
-  //          text_data->fontSize);
-
   // 累积文本到批次，不立即渲染 - 传递NULL作为render_pass
   text_renderer_render_string(renderer, NULL, text_data->stringContents.chars,
                               text_data->stringContents.length, bbox.x,
-                              baseline_y, text_data->textColor,
-                              renderer->default_font_id);
+                              baseline_y, text_data->textColor, font_id,
+                              font_size);
+}
+
+void text_renderer_set_clip_rect(TextRenderer *renderer,
+                                 const Clay_BoundingBox *clip) {
+  if (!renderer)
+    return;
+
+  renderer->clip_enabled = clip != NULL;
+  if (clip)
+    renderer->clip_rect = *clip;
 }
 
 void text_renderer_end_frame(TextRenderer *renderer) {
   if (!renderer)
     return;
 
-  // 这里可以添加帧结束时的清理工作
-  // 当前实现中，批次在每次flush时就被清理了
+  // 提交之后通知环形缓冲区，跟踪在途帧占用的区间
+  gpu_ring_end_frame(&renderer->geometry_ring);
 }
 
 void text_renderer_print_stats(TextRenderer *renderer) {
@@ -1072,10 +2504,31 @@ void text_renderer_print_stats(TextRenderer *renderer) {
   Log("默认字体ID: %d\n", renderer->default_font_id);
   Log("缓存命中: %d\n", renderer->cache_hits);
   Log("缓存未命中: %d\n", renderer->cache_misses);
-  Log("动态生成字形数: %d\n", renderer->dynamic_generations);
-  Log("图集当前位置: (%d, %d)\n", renderer->atlas.current_x,
-      renderer->atlas.current_y);
-  Log("当前批次字符数: %d\n", renderer->current_batch.char_count);
+  Log("动态生成字形数: %d (耗时 %.2f ms)\n", renderer->dynamic_generations,
+      renderer->glyph_generation_ms);
+  Log("后台光栅化字形数: %d (写入图集耗时 %.2f ms, 在途 %d)\n",
+      renderer->async_raster_jobs, renderer->raster_commit_ms,
+      glyph_rasterizer_in_flight(renderer->rasterizer));
+  int shelves = 0, used_rows = 0, allocated = 0;
+  for (int i = 0; i < renderer->atlas.page_count; i++) {
+    shelves += renderer->atlas.pages[i]->packer.shelf_count;
+    used_rows += renderer->atlas.pages[i]->packer.next_shelf_y;
+    allocated += renderer->atlas.pages[i]->packer.allocated_count;
+  }
+  Log("图集页数: %d/%d (纹理 %d 层), 行数: %d, 已用高度: %d, 字形数: %d, "
+      "淘汰字形数: %d\n",
+      renderer->atlas.page_count, TEXT_ATLAS_MAX_PAGES,
+      renderer->atlas.layer_capacity, shelves, used_rows, allocated,
+      renderer->evicted_glyphs);
+  Log("图集上传字节数: %llu\n",
+      (unsigned long long)renderer->atlas_upload_bytes);
+  Log("字符串测量缓存命中: %d, 未命中: %d\n", renderer->measure_hits,
+      renderer->measure_misses);
+  Log("文本段几何缓存命中: %d, 未命中: %d\n", renderer->run_hits,
+      renderer->run_misses);
+  Log("当前批次字符数: %d (已封存 %d 段)\n",
+      renderer->current_batch.char_count,
+      renderer->current_batch.segment_count);
 
   // 计算缓存使用率
   int occupied_slots = 0;
@@ -1096,4 +2549,13 @@ void text_renderer_reset_stats(TextRenderer *renderer) {
   renderer->cache_hits = 0;
   renderer->cache_misses = 0;
   renderer->dynamic_generations = 0;
+  renderer->glyph_generation_ms = 0.0;
+  renderer->atlas_upload_bytes = 0;
+  renderer->evicted_glyphs = 0;
+  renderer->async_raster_jobs = 0;
+  renderer->raster_commit_ms = 0.0;
+  renderer->measure_hits = 0;
+  renderer->measure_misses = 0;
+  renderer->run_hits = 0;
+  renderer->run_misses = 0;
 }
@@ -2,18 +2,52 @@
 #ifndef TEXT_RENDERER_H
 #define TEXT_RENDERER_H
 
+#include "atlas_packer.h"
 #include "clay.h"
+#include "font_coverage.h"
+#include "font_file.h"
+#include "font_kerning.h"
+#include "glyph_rasterizer.h"
+#include "glyph_table.h"
+#include "gpu_ring_buffer.h"
 #include "stb_truetype.h"
+#include "utf8_decoder.h"
 #include <webgpu/wgpu.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 // 配置常量
 #define TEXT_GLYPH_CACHE_SIZE 16384  // 进一步增加缓存大小以支持更多中文字符
-#define TEXT_ATLAS_WIDTH 4096
-#define TEXT_ATLAS_HEIGHT 4096
-#define TEXT_MAX_CHARS_PER_BATCH 2048
+#define TEXT_GLYPH_INDEX_SIZE (TEXT_GLYPH_CACHE_SIZE * 2) // 字形索引键表容量（装载率不超过一半）
+#define TEXT_ASCII_GLYPH_ROWS 4      // 每个字体的ASCII直接索引表行数（每行一个字号）
+#define TEXT_ATLAS_PAGE_SIZE 1024     // 图集每页（纹理数组的一层）的边长
+#define TEXT_ATLAS_MAX_PAGES 16       // 图集页数上限，用满后才淘汰字形
+#if TEXT_ATLAS_PAGE_SIZE > ATLAS_PACKER_MAX_HEIGHT
+#error "TEXT_ATLAS_PAGE_SIZE 超过 ATLAS_PACKER_MAX_HEIGHT，装箱器的行数不够"
+#endif
+#define TEXT_INITIAL_BATCH_CHARS 2048   // 批次初始容量（按需翻倍增长）
+#define TEXT_MAX_CHARS_PER_BATCH 16384  // 单个批次段的实例数上限，写满后封存上传并开始新段
+#define TEXT_GEOMETRY_RING_SIZE (4 * 1024 * 1024)
 #define TEXT_MAX_FONTS 16
+#define TEXT_ATLAS_MAX_DIRTY_RECTS 32   // 两次上传之间跟踪的脏区域上限，超出时合并
+#define TEXT_ATLAS_EVICT_FRAMES 120     // 超过该帧数未使用的字形可被淘汰
+#define TEXT_EXACT_SIZE_LIMIT 32        // 不超过该字号时逐像素缓存字形
+#define TEXT_MAX_RASTER_SIZE 256        // 栅格化字号上限，更大的字号由四边形放大
+#define TEXT_RASTER_COMMIT_BUDGET_MS 1.0 // 每帧把后台光栅化结果写入图集的时间预算
+#define TEXT_CACHE_VERSION 4            // 持久化缓存格式版本，结构或栅格化参数变化时递增
+#define TEXT_LATIN_TABLE_SIZE 256       // 度量快速表覆盖的码点范围（ASCII与Latin-1）
+#define TEXT_MEASURE_CACHE_SIZE 4096    // 字符串宽度缓存条目数（组相联，固定占用）
+#define TEXT_MEASURE_CACHE_WAYS 4
+#define TEXT_DECODE_CHUNK 256           // 测量与绘制时每次批量解码的码点数（栈上缓冲）
+#define TEXT_RUN_CACHE_SIZE 1024        // 文本段几何缓存条目数（组相联）
+#define TEXT_RUN_CACHE_WAYS 4
+#define TEXT_RUN_EVICT_FRAMES 300       // 超过该帧数未绘制的文本段释放其字形数组
+
+// SDF模式：每个字形只生成一份距离场，所有字号共用
+#define TEXT_SDF_BASE_SIZE 48  // 距离场的栅格化字号
+#define TEXT_SDF_PADDING 6     // 距离场四周留白（像素），决定可表示的最大距离
+#define TEXT_SDF_ON_EDGE 128   // 字形边缘对应的距离值
+#define TEXT_SDF_SIZE_KEY 0    // SDF字形在缓存中的字号键（不与位图字号冲突）
 
 // UTF-8相关结构
 typedef struct {
@@ -22,27 +56,67 @@ typedef struct {
     bool valid;
 } UTF8Result;
 
-// 字形信息
+// 字形信息（度量为栅格化字号下的像素值）
 typedef struct {
-    uint32_t codepoint;
+    uint32_t glyph_index; // 字体内的字形索引（映射到同一字形的码点共用）
     float width, height;        // 字形像素尺寸
     float advance;              // 字符前进距离
     float bearing_x, bearing_y; // 字符基准点偏移
-    float u0, v0, u1, v1;      // 纹理坐标
+    float u0, v0, u1, v1;      // 纹理坐标（页内）
+    uint16_t atlas_layer;      // 所在图集页（纹理数组层）
     bool loaded;
+    bool pending; // 后台光栅化中：度量与图集区域已就绪，像素尚未写入，暂不绘制
+    uint16_t gpu_slot; // 在GPU字形表中的槽位（实例通过它引用字形）
 } TextGlyph;
 
+// GPU字形表条目（存储缓冲区，与WGSL中的 Glyph 结构一致）
+// 度量除以栅格化字号，实例只需携带请求字号即可还原像素尺寸
+typedef struct {
+    float uv[4];   // u0, v0, u1, v1
+    float rect[4]; // 相对笔位置的左上角偏移 (x, y) 与尺寸 (w, h)
+    uint32_t layer;
+    uint32_t _pad[3]; // WGSL 结构体按16字节对齐
+} TextGpuGlyph;
+
+// 字形实例（16字节）：顶点着色器从字形表读取尺寸、偏移与纹理坐标
+typedef struct {
+    float pen_x, pen_y; // 基线上的笔位置（像素）
+    uint32_t glyph;     // 低16位为字形表槽位，高16位为请求字号
+    uint8_t color[4];   // RGBA8
+} TextGlyphInstance;
+
+// ASCII字形直接索引表的一行：码点 -> 字形缓存条目槽位 + 1（0 表示未知）
+// 字形被淘汰或回退链变化时 atlas_generation 递增，旧代数的行整行作废
+typedef struct {
+    int pixel_size;
+    uint32_t generation;
+    uint16_t slots[128];
+} TextAsciiGlyphs;
+
 // 字体信息
 typedef struct {
     int font_id;
     char font_path[256];
-    int font_size;
-    float scale;
+    int font_size;  // 加载时指定的默认字号（未指定字号时使用）
+    float scale;    // 默认字号下的缩放比例
     
-    // STB TrueType相关
-    unsigned char *font_buffer;
-    size_t font_buffer_size;
+    // 字体文件映射（与同一文件的其他face共享）
+    int file_index;
+    int face_index;  // TTC字体集合中的序号
+    int face_offset; // face在文件中的偏移
+    uint64_t content_hash; // 字体文件内容哈希，持久化缓存按此匹配字体
+
+    // STB TrueType相关，首次使用时才初始化（face_ready）
     stbtt_fontinfo font_info;
+    FontCoverage coverage; // 码点 -> 字形索引，与 font_info 一同构建
+    FontKerning kerning;   // 字距调整对表，与覆盖索引一同构建
+    // 拉丁字符度量快速表，测量时不经覆盖索引和字形缓存
+    uint16_t latin_glyphs[TEXT_LATIN_TABLE_SIZE];  // 0 表示本字体不包含（走回退链）
+    int16_t latin_advances[TEXT_LATIN_TABLE_SIZE]; // 字体单位
+    // ASCII字形直接索引，绘制时跳过字形缓存的哈希查找
+    TextAsciiGlyphs ascii_glyphs[TEXT_ASCII_GLYPH_ROWS];
+    int ascii_next_row; // 没有匹配字号时轮流替换的行
+    bool face_ready;
     
     // 字体度量信息
     int ascent, descent, line_gap;
@@ -51,35 +125,96 @@ typedef struct {
     bool loaded;
 } TextFont;
 
-// 字体纹理图集
+// 图集的一页，对应纹理数组的一层
+typedef struct {
+    unsigned char *pixels; // TEXT_ATLAS_PAGE_SIZE 见方
+    AtlasPacker packer;    // 字形矩形分配，淘汰时原地回收
+
+    // 自上次上传以来新写入的区域，上传时只提交这些子矩形
+    AtlasPackerRect dirty_rects[TEXT_ATLAS_MAX_DIRTY_RECTS];
+    int dirty_rect_count;
+} TextAtlasPage;
+
+// 字体纹理图集：纹理数组，现有页放不下时按需加页
+// 纹理层数按倍数预留，层数不够时才重建纹理（旧层在GPU上复制）与绑定组
 typedef struct {
     WGPUTexture texture;
     WGPUTextureView texture_view;
     WGPUSampler sampler;
     WGPUBindGroup bind_group;
     
-    unsigned char *pixels;
-    int current_x, current_y;
-    int line_height;
+    TextAtlasPage *pages[TEXT_ATLAS_MAX_PAGES];
+    int page_count;
+    int layer_capacity; // 纹理当前的层数
     
     bool dirty;  // 标记纹理是否需要更新
 } TextAtlas;
 
-// 字形缓存条目
+// 字形缓存条目，按（字形索引、字体、栅格化字号）索引
 typedef struct {
-    uint32_t codepoint;
+    uint32_t glyph_index;
     int font_id;
+    int pixel_size; // 栅格化字号
     TextGlyph glyph;
     bool occupied;
+
+    AtlasPackerRect atlas_rect; // 字形在图集中占用的区域
+    int atlas_shelf;            // 所在行，-1 表示不占用图集（空白字符）
+    uint32_t last_used_frame;   // 最近一次被查找的帧序号（LRU淘汰依据）
+    uint32_t raster_job;        // 在途光栅化任务编号，0 表示没有
 } TextGlyphCacheEntry;
 
-// 文本渲染批次
+// 字符串宽度缓存条目，按（内容哈希、字节长度、字体、字号）索引
+typedef struct {
+    uint64_t hash; // 0 表示空
+    int length;
+    int font_id;
+    int font_size;
+    float width;
+    uint32_t last_used_frame; // 组内按此替换最久未用的条目
+} TextMeasureEntry;
+
+// 文本段中一个可见字形（相对于文本起点的像素坐标）
+typedef struct {
+    float pen_x, pen_y;
+    uint32_t glyph;       // 同 TextGlyphInstance.glyph
+    float x1, y1, x2, y2; // 四边形范围，写入批次时用于裁剪剔除
+} TextRunGlyph;
+
+// 文本段几何缓存条目，按（内容哈希、字节长度、字体、字号）索引
+// 颜色与起点在写入批次时才应用，同一文本在不同位置、颜色下共用一份排版结果
+// 字形通过GPU字形表槽位引用，字形被淘汰（槽位可能复用）后整段失效
+typedef struct {
+    uint64_t hash; // 0 表示空
+    int length;
+    int font_id;
+    int font_size;
+    TextRunGlyph *glyphs;
+    int glyph_count;
+    int glyph_capacity;
+    uint32_t atlas_generation; // 排版时的图集代数，字形被淘汰后失效
+    uint32_t last_used_frame;
+} TextRun;
+
+// 已封存的批次段：实例已上传到环形缓冲区
+typedef struct {
+    GpuRingAllocation alloc;
+    int first; // 段内第一个实例在本帧中的序号
+    int count;
+} TextBatchSegment;
+
+// 文本渲染批次：每个字形一个实例，绘制时每个实例展开为6个顶点
+// 实例按本帧内的序号编址；写满 TEXT_MAX_CHARS_PER_BATCH 个实例时当前段被封存上传，
+// 之后的实例写入新段，绘制区间跨段时按段拆成多次绘制
 typedef struct {
-    float *vertex_data;     // 顶点数据缓冲区
-    uint16_t *index_data;   // 索引数据缓冲区
-    int vertex_count;       // 当前顶点数量
-    int index_count;        // 当前索引数量
-    int char_count;         // 当前字符数量
+    TextGlyphInstance *instances; // 当前（未封存）段的实例数据
+    int char_count;         // 本帧字符（实例）总数
+    int char_capacity;      // 当前段已分配的字符容量
+    int segment_first;      // 当前段第一个实例的序号
+
+    TextBatchSegment *segments; // 本帧已封存的段
+    int segment_count;
+    int segment_capacity;
     
     int font_id;            // 当前批次字体ID
 } TextRenderBatch;
@@ -90,33 +225,81 @@ typedef struct {
     WGPUDevice device;
     WGPUQueue queue;
     WGPURenderPipeline text_pipeline;
+    WGPURenderPipeline sdf_pipeline;
+    bool sdf_mode; // 使用距离场字形（在帧之间切换）
     
-    // 缓冲区
-    WGPUBuffer vertex_buffer;
-    WGPUBuffer index_buffer;
+    // 字形实例环形缓冲区（按帧子分配）
+    GpuRingBuffer geometry_ring;
     
     // 屏幕信息
     uint32_t screen_width;
     uint32_t screen_height;
     
     // 字体管理
+    FontFile font_files[TEXT_MAX_FONTS]; // 按路径共享的只读映射
     TextFont fonts[TEXT_MAX_FONTS];
     int font_count;
     int default_font_id;
+    int fallback_fonts[TEXT_MAX_FONTS]; // 回退链，按加入顺序查找
+    int fallback_count;
     
     // 纹理图集
     TextAtlas atlas;
     
-    // 字形缓存
+    // 字形缓存：条目按槽位稠密存放（槽位即GPU字形表槽位），生命周期内不移动；
+    // 查找经 glyph_lookup 从打包键映射到槽位
     TextGlyphCacheEntry glyph_cache[TEXT_GLYPH_CACHE_SIZE];
+    GlyphTable glyph_lookup;
+
+    // GPU字形表：按槽位镜像字形缓存，上传批次前只写入变化的区间
+    // 槽位随条目分配、删除时回收，回收的槽位到下一帧才复用，
+    // 本帧已写入批次的实例不会读到别的字形
+    TextGpuGlyph gpu_glyphs[TEXT_GLYPH_CACHE_SIZE];
+    WGPUBuffer glyph_table_buffer;
+    WGPUBuffer screen_uniform_buffer;
+    uint16_t gpu_free_slots[TEXT_GLYPH_CACHE_SIZE];
+    int gpu_free_count;
+    uint16_t gpu_retired_slots[TEXT_GLYPH_CACHE_SIZE];
+    int gpu_retired_count;
+    int gpu_dirty_min, gpu_dirty_max; // 待上传的槽位区间，min > max 表示没有
+
+    // 字符串宽度缓存：Clay 每次布局都逐词测量，同一词的结果直接复用
+    TextMeasureEntry measure_cache[TEXT_MEASURE_CACHE_SIZE];
+
+    // 文本段几何缓存：逐帧不变的标签直接复用排版好的字形四边形
+    TextRun run_cache[TEXT_RUN_CACHE_SIZE];
+    TextRunGlyph *run_scratch; // 排版暂存区
+    int run_scratch_capacity;
+    uint32_t atlas_generation; // 有字形被淘汰（纹理坐标失效）时递增
+
+    // 后台光栅化：未命中的字形先返回 pending 状态，结果在下一帧开始时写入图集
+    GlyphRasterizer *rasterizer; // 线程创建失败时为 NULL（同步光栅化）
+    bool async_raster;
+    uint32_t next_raster_job;
     
     // 渲染批次
     TextRenderBatch current_batch;
+    int bound_segment; // 渲染通道中当前绑定的段，-1 表示没有
     
+    uint32_t frame_index; // 帧序号，每次 begin_frame 递增
+
+    // 当前裁剪区域（像素坐标），完全在外的字形不写入批次
+    bool clip_enabled;
+    Clay_BoundingBox clip_rect;
+
     // 统计信息
     int cache_hits;
     int cache_misses;
     int dynamic_generations;
+    double glyph_generation_ms; // 字形光栅化累计耗时
+    uint64_t atlas_upload_bytes; // 图集上传的像素字节数
+    int evicted_glyphs;          // 因图集空间不足被淘汰的字形数
+    int async_raster_jobs;       // 提交到后台光栅化的字形数
+    double raster_commit_ms;     // 写入后台光栅化结果的累计耗时
+    int measure_hits;            // 字符串宽度缓存命中
+    int measure_misses;
+    int run_hits;                // 文本段几何缓存命中
+    int run_misses;
 } TextRenderer;
 
 // API函数声明
@@ -129,37 +312,75 @@ void text_renderer_update_screen_size(TextRenderer *renderer,
                                      uint32_t screen_width, uint32_t screen_height);
 
 // 字体管理
+// 同一字体只加载一次，重复加载返回已有的字体ID
+// 文件只读映射并在各face之间共享，字体表在首次使用时才解析
 int text_renderer_load_font(TextRenderer *renderer, const char *font_path, int font_size);
+int text_renderer_load_font_face(TextRenderer *renderer, const char *font_path,
+                                 int face_index, int font_size);
 bool text_renderer_set_default_font(TextRenderer *renderer, int font_id);
+// 把字体加入回退链：请求字体不包含某个码点时按加入顺序依次查找
+bool text_renderer_add_fallback_font(TextRenderer *renderer, int font_id);
 TextFont* text_renderer_get_font(TextRenderer *renderer, int font_id);
 
 // UTF-8处理
 UTF8Result text_decode_utf8(const char **utf8_str);
 int text_utf8_string_length(const char *utf8_str, int byte_length);
 
-// 字形管理
-TextGlyph* text_renderer_get_glyph(TextRenderer *renderer, uint32_t codepoint, int font_id);
-bool text_renderer_generate_glyph(TextRenderer *renderer, uint32_t codepoint, int font_id);
+// 字号：font_size <= 0 时使用字体加载时的默认字号
+// 请求字号映射到有限的栅格化字号集合（分桶），避免字号动画时图集膨胀
+int text_renderer_raster_size(int font_size);
+float text_renderer_font_scale(const TextFont *font, int font_size);
+
+// 字形管理：返回栅格化字号 text_renderer_raster_size(font_size) 下的字形
+// 码点经覆盖索引（含回退链）解析为字形索引，缓存与光栅化都按字形索引进行
+TextGlyph* text_renderer_get_glyph(TextRenderer *renderer, uint32_t codepoint,
+                                   int font_id, int font_size);
+// 直接按字形索引获取（连字等排版输出不对应单个码点）
+TextGlyph* text_renderer_get_glyph_by_index(TextRenderer *renderer, uint32_t glyph_index,
+                                            int font_id, int font_size);
+bool text_renderer_generate_glyph(TextRenderer *renderer, uint32_t glyph_index,
+                                  int font_id, int pixel_size);
 void text_renderer_flush_atlas(TextRenderer *renderer);
+// 切换SDF模式；两种字形在缓存中并存，不再使用的一种由LRU淘汰
+void text_renderer_set_sdf_mode(TextRenderer *renderer, bool enabled);
+// 关闭后未命中的字形在渲染线程上同步光栅化（金图回归需要首帧完整）
+void text_renderer_set_async_raster(TextRenderer *renderer, bool enabled);
+
+// 持久化字形缓存：保存图集像素、装箱器状态与字形表，下次启动时一次性恢复
+// 加载须在字体加载之后、生成任何字形之前调用；字体按文件内容哈希匹配，
+// 已不再加载的字体对应的字形被丢弃
+bool text_renderer_save_cache(TextRenderer *renderer, const char *path);
+bool text_renderer_load_cache(TextRenderer *renderer, const char *path);
 
-// 文本测量
+// 文本测量：只读取字体度量，不生成字形；结果按字符串缓存
+// text_length 为字节数（Clay 的字符串切片不以NUL结尾），<= 0 时按NUL结尾处理
 float text_renderer_measure_string_width(TextRenderer *renderer, const char *text, 
-                                        int font_id, int max_chars);
-float text_renderer_get_line_height(TextRenderer *renderer, int font_id);
+                                        int font_id, int font_size, int text_length);
+float text_renderer_get_line_height(TextRenderer *renderer, int font_id, int font_size);
 
 // 文本渲染
 void text_renderer_begin_frame(TextRenderer *renderer);
 void text_renderer_render_string(TextRenderer *renderer, WGPURenderPassEncoder render_pass,
                                 const char *text, int text_length,
-                                float x, float y, Clay_Color color, int font_id);
+                                float x, float y, Clay_Color color,
+                                int font_id, int font_size);
 void text_renderer_render_clay_text(TextRenderer *renderer, WGPURenderPassEncoder render_pass,
                                    Clay_TextRenderData *text_data, Clay_BoundingBox bbox);
-void text_renderer_end_frame(TextRenderer *renderer);
+void text_renderer_end_frame(TextRenderer *renderer); // 在队列提交之后调用
+// 设置CPU端字形裁剪区域，clip 为 NULL 时关闭裁剪
+void text_renderer_set_clip_rect(TextRenderer *renderer, const Clay_BoundingBox *clip);
 
 // 批量渲染内部函数
 void text_renderer_flush_batch(TextRenderer *renderer, WGPURenderPassEncoder render_pass);
+// 分段绘制：先整体上传批次，再绑定一次，由调用方按实例区间多次绘制
+bool text_renderer_upload_batch(TextRenderer *renderer);
+void text_renderer_bind_batch(TextRenderer *renderer, WGPURenderPassEncoder render_pass);
+// 绘制本帧序号为 [first, first + count) 的实例，跨越批次段时拆分为多次绘制
+void text_renderer_draw_range(TextRenderer *renderer, WGPURenderPassEncoder render_pass,
+                              uint32_t first, uint32_t count);
 void text_renderer_add_char_to_batch(TextRenderer *renderer, uint32_t codepoint, 
-                                    float x, float y, int font_id, Clay_Color color);
+                                    float x, float y, int font_id, int font_size,
+                                    Clay_Color color);
 
 // 调试和统计
 void text_renderer_print_stats(TextRenderer *renderer);
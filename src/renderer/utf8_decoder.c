@@ -0,0 +1,125 @@
+// utf8_decoder.c - 批量UTF-8解码实现
+#include "utf8_decoder.h"
+#include <stdbool.h>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTF8_DECODER_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define UTF8_DECODER_NEON 1
+#endif
+
+#define UTF8_SIMD_WIDTH 16
+
+// 16字节全部为非零ASCII时展开为码点并返回 true
+static bool expand_ascii_block(const unsigned char *s, uint32_t *out) {
+#if defined(UTF8_DECODER_SSE2)
+  __m128i bytes = _mm_loadu_si128((const __m128i *)s);
+  __m128i zero = _mm_setzero_si128();
+  // 最高位为1表示非ASCII，等于0表示NUL
+  if (_mm_movemask_epi8(bytes) != 0 ||
+      _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero)) != 0)
+    return false;
+
+  __m128i low = _mm_unpacklo_epi8(bytes, zero);
+  __m128i high = _mm_unpackhi_epi8(bytes, zero);
+  _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi16(low, zero));
+  _mm_storeu_si128((__m128i *)(out + 4), _mm_unpackhi_epi16(low, zero));
+  _mm_storeu_si128((__m128i *)(out + 8), _mm_unpacklo_epi16(high, zero));
+  _mm_storeu_si128((__m128i *)(out + 12), _mm_unpackhi_epi16(high, zero));
+  return true;
+#elif defined(UTF8_DECODER_NEON)
+  uint8x16_t bytes = vld1q_u8(s);
+  if (vmaxvq_u8(bytes) >= 0x80 || vminvq_u8(bytes) == 0)
+    return false;
+
+  uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+  uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+  vst1q_u32(out, vmovl_u16(vget_low_u16(low)));
+  vst1q_u32(out + 4, vmovl_u16(vget_high_u16(low)));
+  vst1q_u32(out + 8, vmovl_u16(vget_low_u16(high)));
+  vst1q_u32(out + 12, vmovl_u16(vget_high_u16(high)));
+  return true;
+#else
+  // 标量：一次检查8字节
+  for (int half = 0; half < UTF8_SIMD_WIDTH; half += 8) {
+    uint64_t word = 0;
+    for (int i = 0; i < 8; i++)
+      word |= (uint64_t)s[half + i] << (i * 8);
+    // 最高位检查与“是否含零字节”位技巧
+    if ((word & 0x8080808080808080ull) ||
+        ((word - 0x0101010101010101ull) & ~word & 0x8080808080808080ull))
+      return false;
+  }
+  for (int i = 0; i < UTF8_SIMD_WIDTH; i++)
+    out[i] = s[i];
+  return true;
+#endif
+}
+
+// 解码一个多字节序列（首字节 >= 0x80），返回消耗的字节数
+static int decode_sequence(const unsigned char *s, int remaining,
+                           uint32_t *codepoint) {
+  unsigned char lead = s[0];
+  if ((lead & 0xE0) == 0xC0 && remaining >= 2 && (s[1] & 0xC0) == 0x80) {
+    uint32_t cp = (uint32_t)(lead & 0x1F) << 6 | (s[1] & 0x3F);
+    if (cp >= 0x80) {
+      *codepoint = cp;
+      return 2;
+    }
+  } else if ((lead & 0xF0) == 0xE0 && remaining >= 3 &&
+             (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80) {
+    uint32_t cp = (uint32_t)(lead & 0x0F) << 12 | (uint32_t)(s[1] & 0x3F) << 6 |
+                  (s[2] & 0x3F);
+    if (cp >= 0x800) {
+      *codepoint = cp;
+      return 3;
+    }
+  } else if ((lead & 0xF8) == 0xF0 && remaining >= 4 &&
+             (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80 &&
+             (s[3] & 0xC0) == 0x80) {
+    uint32_t cp = (uint32_t)(lead & 0x07) << 18 |
+                  (uint32_t)(s[1] & 0x3F) << 12 | (uint32_t)(s[2] & 0x3F) << 6 |
+                  (s[3] & 0x3F);
+    if (cp >= 0x10000 && cp <= 0x10FFFF) {
+      *codepoint = cp;
+      return 4;
+    }
+  }
+
+  *codepoint = UTF8_REPLACEMENT_CHAR;
+  return 1;
+}
+
+int utf8_decode_run(const char *text, int length, uint32_t *codepoints,
+                    int capacity, int *consumed) {
+  const unsigned char *s = (const unsigned char *)text;
+  int pos = 0;
+  int count = 0;
+
+  while (pos < length && count < capacity) {
+    // 整块ASCII（常见的英文、数字与标点）
+    if (length - pos >= UTF8_SIMD_WIDTH &&
+        capacity - count >= UTF8_SIMD_WIDTH &&
+        expand_ascii_block(s + pos, codepoints + count)) {
+      pos += UTF8_SIMD_WIDTH;
+      count += UTF8_SIMD_WIDTH;
+      continue;
+    }
+
+    unsigned char byte = s[pos];
+    if (byte == 0)
+      break;
+    if (byte < 0x80) {
+      codepoints[count++] = byte;
+      pos++;
+    } else {
+      pos += decode_sequence(s + pos, length - pos, &codepoints[count++]);
+    }
+  }
+
+  *consumed = pos;
+  return count;
+}
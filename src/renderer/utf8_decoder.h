@@ -0,0 +1,17 @@
+// utf8_decoder.h - 批量UTF-8解码：整段展开为码点数组
+// 纯ASCII段每次用SIMD（SSE2/NEON）处理16字节，多字节序列逐个解码；
+// 非法字节按一个字节解码为 U+FFFD，与 text_decode_utf8 的行为一致
+#ifndef UTF8_DECODER_H
+#define UTF8_DECODER_H
+
+#include <stdint.h>
+
+#define UTF8_REPLACEMENT_CHAR 0xFFFD
+
+// 解码 [text, text + length) 中的码点，最多写入 capacity 个，返回写入个数；
+// *consumed 返回已消耗的字节数。遇到NUL时停止（NUL不计入），
+// 此时 *consumed < length 且返回值小于 capacity
+int utf8_decode_run(const char *text, int length, uint32_t *codepoints,
+                    int capacity, int *consumed);
+
+#endif // UTF8_DECODER_H